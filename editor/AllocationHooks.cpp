@@ -0,0 +1,87 @@
+#include "dei_platform/Allocation.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new/delete of the executable, the engine library
+// and libdeiPlatform resolve to these as well. Built without exceptions,
+// so a failed allocation aborts instead of throwing std::bad_alloc
+
+namespace {
+
+// Every block is prefixed by a header right before the returned pointer, it remembers the tag
+// the block was counted under, so the free is attributed to the same tag whatever thread or scope frees it.
+// HEADER_BYTES keeps the fundamental alignment of malloc for the returned pointer
+constexpr std::size_t HEADER_BYTES = alignof(std::max_align_t);
+
+struct BlockHeader {
+    // from the start of the underlying allocation to the returned pointer
+    std::size_t Offset;
+    dei::platform::AllocationTag Tag;
+};
+static_assert(sizeof(BlockHeader) <= HEADER_BYTES, "BlockHeader must fit in front of the block");
+
+inline auto WriteHeader(void* base, std::size_t offset, dei::platform::AllocationTag tag) -> void* {
+    if (base == nullptr) {
+        return nullptr;
+    }
+    auto* pointer = static_cast<char*>(base) + offset;
+    ::new (pointer - HEADER_BYTES) BlockHeader{offset, tag};
+    return pointer;
+}
+
+inline auto Allocate(std::size_t size) -> void* {
+    auto tag = dei::platform::AllocationOnNew(size);
+    return ::WriteHeader(std::malloc(size + HEADER_BYTES), HEADER_BYTES, tag);
+}
+
+inline auto AllocateAligned(std::size_t size, std::align_val_t alignment) -> void* {
+    auto tag = dei::platform::AllocationOnNew(size);
+    // the header takes a whole alignment unit, so the returned pointer stays aligned
+    auto alignmentBytes = std::max(static_cast<std::size_t>(alignment), HEADER_BYTES);
+    // aligned_alloc wants the size to be a multiple of alignment
+    auto alignedSize = (size + alignmentBytes + alignmentBytes - 1) & ~(alignmentBytes - 1);
+    return ::WriteHeader(std::aligned_alloc(alignmentBytes, alignedSize), alignmentBytes, tag);
+}
+
+inline auto Deallocate(void* pointer) -> void {
+    if (pointer == nullptr) {
+        return;
+    }
+    auto* header = reinterpret_cast<BlockHeader*>(static_cast<char*>(pointer) - HEADER_BYTES);
+    dei::platform::AllocationOnDelete(header->Tag);
+    std::free(static_cast<char*>(pointer) - header->Offset);
+}
+
+inline auto OrAbort(void* pointer) -> void* {
+    if (pointer == nullptr) {
+        std::abort();
+    }
+    return pointer;
+}
+
+} // namespace ::
+
+auto operator new(std::size_t size) -> void* { return ::OrAbort(::Allocate(size)); }
+auto operator new[](std::size_t size) -> void* { return ::OrAbort(::Allocate(size)); }
+auto operator new(std::size_t size, const std::nothrow_t&) noexcept -> void* { return ::Allocate(size); }
+auto operator new[](std::size_t size, const std::nothrow_t&) noexcept -> void* { return ::Allocate(size); }
+auto operator new(std::size_t size, std::align_val_t alignment) -> void* { return ::OrAbort(::AllocateAligned(size, alignment)); }
+auto operator new[](std::size_t size, std::align_val_t alignment) -> void* { return ::OrAbort(::AllocateAligned(size, alignment)); }
+auto operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept -> void* { return ::AllocateAligned(size, alignment); }
+auto operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept -> void* { return ::AllocateAligned(size, alignment); }
+
+auto operator delete(void* pointer) noexcept -> void { ::Deallocate(pointer); }
+auto operator delete[](void* pointer) noexcept -> void { ::Deallocate(pointer); }
+auto operator delete(void* pointer, std::size_t) noexcept -> void { ::Deallocate(pointer); }
+auto operator delete[](void* pointer, std::size_t) noexcept -> void { ::Deallocate(pointer); }
+auto operator delete(void* pointer, const std::nothrow_t&) noexcept -> void { ::Deallocate(pointer); }
+auto operator delete[](void* pointer, const std::nothrow_t&) noexcept -> void { ::Deallocate(pointer); }
+auto operator delete(void* pointer, std::align_val_t) noexcept -> void { ::Deallocate(pointer); }
+auto operator delete[](void* pointer, std::align_val_t) noexcept -> void { ::Deallocate(pointer); }
+auto operator delete(void* pointer, std::size_t, std::align_val_t) noexcept -> void { ::Deallocate(pointer); }
+auto operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept -> void { ::Deallocate(pointer); }
+auto operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept -> void { ::Deallocate(pointer); }
+auto operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept -> void { ::Deallocate(pointer); }
@@ -0,0 +1,200 @@
+#include "dei_platform/Util.hpp"
+#include "dei_platform/Window.hpp"
+#include "dei_platform/Time.hpp"
+#include "dei_platform/Allocation.hpp"
+#include "dei_platform/Log.hpp"
+
+#include "dei/Prelude.hpp"
+
+#define CR_HOST CR_UNSAFE // required in the host only and before including cr.h
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Weverything"
+#include <cr.h>
+#pragma clang diagnostic pop
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+auto OnWindowError(int code, const char* description) {
+    fprintf(stderr, "Error GLFW %d: %s\n", code, description);
+}
+
+inline auto NanosecToMs(i64 nanosec) -> f64 {
+    return static_cast<f64>(nanosec) * 1e-6;
+}
+
+inline auto Percentile(const std::vector<i64>& sortedNanosec, u32 percentile) -> f64 {
+    auto index = std::min(sortedNanosec.size() - 1, (sortedNanosec.size() * percentile) / 100);
+    return NanosecToMs(sortedNanosec[index]);
+}
+
+// the engine reports to stdout as well, so the result can go to a separate file
+auto OpenOutput(const char* outputPath) -> std::FILE* {
+    if (outputPath == nullptr || std::string{outputPath} == "-") {
+        return stdout;
+    }
+    return std::fopen(outputPath, "w");
+}
+
+} // namespace ::
+
+// Runs the engine library without vsync, pacing or a visible window,
+// prints results as JSON. Works on a software Vulkan driver (lavapipe).
+// args:
+// 1: install directory path (absolute)
+// 2: engine library basename (e.g. dei)
+// 3: number of measured engine ticks (with DEI_INPUT_REPLAY at most until the last recorded frame)
+// 4: number of warm up engine ticks (not measured)
+// 5: JSON output file path ("-" is stdout)
+auto main(int argc, char *argv[]) -> int {
+    assert(argc >= 3);
+    u32 numTicks = static_cast<u32>(argc >= 4 ? std::stoul(argv[3]) : 10000UL);
+    u32 numWarmupTicks = static_cast<u32>(argc >= 5 ? std::stoul(argv[4]) : 100UL);
+    const char* outputPath = argc >= 6 ? argv[5] : "-";
+    numTicks = std::max(numTicks, 1u);
+    dei::platform::AllocationGuardSetMode(dei::platform::AllocationGuardModeFromEnvironment());
+    // the engine's logging stays off the measured ticks
+    dei::platform::LogStart();
+
+    auto windowSystem = dei::platform::CreateWindowSystem(&OnWindowError);
+    auto windowBuilder = dei::platform::WindowBuilder{};
+    windowBuilder
+        .WithVulkan(1, 3)
+        .WithSize(800, 600)
+        .WithTitleUtf8("dei bench")
+        .WithVisible(false)
+        .WithFocused(false);
+    auto maybeWindow = dei::platform::CreateWindow(windowSystem, std::move(windowBuilder));
+    if (maybeWindow == std::nullopt) {
+        fprintf(stderr, "Window creation failed\n");
+        return 1;
+    }
+    auto window = *std::move(maybeWindow);
+    dei::platform::SetVerticalSync(windowSystem, false);
+    // measures the engine, not the display refresh
+    dei::platform::WindowSetPresentPolicy(window, dei::platform::PresentPolicy::UNCAPPED);
+    // DEI_INPUT_REPLAY drives the engine with a session recorded by the host (DEI_INPUT_RECORD)
+    dei::platform::WindowStartInputRecordingFromEnvironment(window);
+    b8 isReplayingInput = dei::platform::WindowIsReplayingInput(window);
+
+    auto engineDependencies = dei::EngineDependencies{};
+    engineDependencies.RequiredHostExtensionCount = dei::platform::WindowVulkanGetRequiredExtensionsCount(window);
+    engineDependencies.RequiredHostExtensions = dei::platform::WindowVulkanGetRequiredExtensions(window);
+    engineDependencies.CreateVkSurfaceCallback = [&](VkInstance instance){
+        auto maybeSurface = dei::platform::WindowInitializeVulkanBackend(window, instance);
+        if (maybeSurface == std::nullopt) {
+            fprintf(stderr, "GLFW Failed to create VkSurfaceKHR\n");
+            std::exit(1);
+        }
+        return *maybeSurface;
+    };
+    // no FrameStats: the engine would report them to stdout periodically
+    engineDependencies.FrameStats = nullptr;
+    engineDependencies.Input = &dei::platform::WindowGetInputSnapshot(window);
+    engineDependencies.WindowSurface = &dei::platform::WindowGetSurfaceState(window);
+    // replays advance the simulation by the recorded frame times
+    engineDependencies.FrameNanosec = &dei::platform::WindowGetFrameNanosec(window);
+    auto engineHotReloadState = dei::EngineHotReloadState{
+        dei::EngineState{},
+        engineDependencies,
+    };
+
+    // startup: library load, then the first update runs cold and hot startup (and one tick)
+    auto engineHotReloader = cr_plugin{};
+    engineHotReloader.userdata = static_cast<void*>(&engineHotReloadState);
+    auto engineLibPath = dei::platform::MakeLibraryFilepath(argv[1], argv[2]);
+    auto openBegin = dei::platform::GetMonotonicNanosec();
+    if (cr_plugin_open(engineHotReloader, engineLibPath.c_str()) == false) {
+        fprintf(stderr, "Failed to open %s\n", engineLibPath.c_str());
+        return 1;
+    }
+    // same per frame input sequence as in the host, the recording's first frame is the startup
+    dei::platform::PollWindowEvents(windowSystem);
+    dei::platform::WindowBeginInputFrame(window);
+    dei::platform::WindowLatchInputState(window);
+    auto startupBegin = dei::platform::GetMonotonicNanosec();
+    if (cr_plugin_update(engineHotReloader, true) != 0) {
+        fprintf(stderr, "Engine startup failed\n");
+        cr_plugin_close(engineHotReloader);
+        return 1;
+    }
+    auto startupEnd = dei::platform::GetMonotonicNanosec();
+
+    // a replay is measured until its last recorded frame, the ticks after it would follow the live clock
+    auto isTickRecorded = [&]() { return !isReplayingInput || dei::platform::WindowIsReplayingInput(window); };
+    for (u32 i = 0; i < numWarmupTicks && isTickRecorded(); ++i) {
+        dei::platform::PollWindowEvents(windowSystem);
+        dei::platform::WindowBeginInputFrame(window);
+        dei::platform::WindowLatchInputState(window);
+        cr_plugin_update(engineHotReloader, false);
+    }
+
+    auto frameNanosec = std::vector<i64>(numTicks);
+    b8 engineFailed = false;
+    auto allocationsBegin = dei::platform::AllocationGetTotalCount();
+    auto measureBegin = dei::platform::GetMonotonicNanosec();
+    auto frameBegin = measureBegin;
+    u32 numMeasuredTicks = 0;
+    for (; numMeasuredTicks < numTicks && !engineFailed && isTickRecorded(); ++numMeasuredTicks) {
+        dei::platform::PollWindowEvents(windowSystem);
+        dei::platform::WindowBeginInputFrame(window);
+        dei::platform::WindowLatchInputState(window);
+        engineFailed = cr_plugin_update(engineHotReloader, false) != 0;
+        auto frameEnd = dei::platform::GetMonotonicNanosec();
+        frameNanosec[numMeasuredTicks] = frameEnd - frameBegin;
+        frameBegin = frameEnd;
+    }
+    auto measureEnd = frameBegin;
+    auto numAllocations = dei::platform::AllocationGetTotalCount() - allocationsBegin;
+    auto drawCounter = engineHotReloadState.EngineState.DrawCounter;
+    auto simulationSteps = engineHotReloadState.EngineState.Timestep.NumSteps;
+
+    cr_plugin_close(engineHotReloader);
+    dei::platform::LogStop();
+    if (engineFailed) {
+        fprintf(stderr, "Engine tick failed\n");
+        return 1;
+    }
+    if (numMeasuredTicks == 0) {
+        fprintf(stderr, "The input recording ended during the warm up ticks\n");
+        return 1;
+    }
+    frameNanosec.resize(numMeasuredTicks);
+
+    auto totalSec = NanosecToMs(measureEnd - measureBegin) * 1e-3;
+    auto numTicksMeasured = static_cast<f64>(numMeasuredTicks);
+    std::sort(frameNanosec.begin(), frameNanosec.end());
+    i64 sumNanosec = 0;
+    for (auto nanosec : frameNanosec) {
+        sumNanosec += nanosec;
+    }
+
+    auto* output = ::OpenOutput(outputPath);
+    if (output == nullptr) {
+        fprintf(stderr, "Can't open %s\n", outputPath);
+        return 1;
+    }
+    fprintf(output,
+        "{\"benchmark\":\"engine_tick\",\"ticks\":%u,\"warmup_ticks\":%u,\"draw_counter\":%u,\"simulation_steps\":%lu,"
+        "\"input_replay\":%s,"
+        "\"allocations\":%lu,\"allocations_per_tick\":%.3f,"
+        "\"library_open_ms\":%.3f,\"startup_ms\":%.3f,\"total_s\":%.6f,\"fps\":%.2f,"
+        "\"frame_ms\":{\"mean\":%.6f,\"p50\":%.6f,\"p90\":%.6f,\"p95\":%.6f,\"p99\":%.6f,\"max\":%.6f}}\n",
+        numMeasuredTicks, numWarmupTicks, drawCounter, simulationSteps, isReplayingInput ? "true" : "false",
+        numAllocations, static_cast<f64>(numAllocations) / numTicksMeasured,
+        NanosecToMs(startupBegin - openBegin), NanosecToMs(startupEnd - startupBegin),
+        totalSec, numTicksMeasured / totalSec,
+        NanosecToMs(sumNanosec) / numTicksMeasured,
+        Percentile(frameNanosec, 50), Percentile(frameNanosec, 90),
+        Percentile(frameNanosec, 95), Percentile(frameNanosec, 99),
+        NanosecToMs(frameNanosec.back()));
+    if (output != stdout) {
+        std::fclose(output);
+    }
+    return 0;
+}
@@ -1,6 +1,16 @@
 #include "dei_platform/Util.hpp"
 #include "dei_platform/Window.hpp"
 #include "dei_platform/Time.hpp"
+#include "dei_platform/FramePacer.hpp"
+#include "dei_platform/FrameStats.hpp"
+#include "dei_platform/LatencyProbe.hpp"
+#include "dei_platform/FlightRecorder.hpp"
+#include "dei_platform/IdlePolicy.hpp"
+#include "dei_platform/MetricsPage.hpp"
+#include "dei_platform/Allocation.hpp"
+#include "dei_platform/VulkanAllocator.hpp"
+#include "dei_platform/Profiler.hpp"
+#include "dei_platform/Log.hpp"
 #include "dei_platform/Mouse.hpp"
 #include "dei_platform/Monitor.hpp"
 
@@ -15,27 +25,34 @@ using namespace dei::platform::input;
 #include <cr.h>
 #pragma clang diagnostic pop
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
+#include <cstring>
 #include <string>
-#include <iostream>
-
-struct EngineHotReloadState {
-    dei::EngineState EngineState;
-    dei::EngineDependencies EngineDependencies;
-};
-
-auto OnTextInput(const std::string& currentInputUtf8, u32 latestCodepoint) {
-    (void)latestCodepoint;
-    std::cout << currentInputUtf8 << '\n';
+#include <memory>
+#include <mutex>
+#include <thread>
+
+auto OnTextInput(const dei::platform::input::TextEdit& edit) {
+    // the edited text isn't null-terminated, long pastes are cut (maybe mid codepoint, it's only printed)
+    char text[128];
+    auto numBytes = std::min(edit.TextUtf8.size(), sizeof(text) - 1);
+    std::memcpy(text, edit.TextUtf8.data(), numBytes);
+    text[numBytes] = '\0';
+    DEI_LOG_INFO("%c%s%s (at %u, total %u bytes)\n",
+        edit.Type == dei::platform::input::TextEditType::INSERT ? '+' : '-',
+        text, numBytes < edit.TextUtf8.size() ? "..." : "", edit.OffsetBytes, edit.TotalBytes);
 }
 
 auto OnWindowResized(int newWidthPx, int newHeightPx) {
-    printf("New size %d %d\n", newWidthPx, newHeightPx);
+    DEI_LOG_INFO("New size %d %d\n", newWidthPx, newHeightPx);
 
 }
 
 auto OnWindowMoved(int leftUpCornerX, int leftUpCornerY) {
-    printf("New pos %d %d\n", leftUpCornerX, leftUpCornerY);
+    DEI_LOG_INFO("New pos %d %d\n", leftUpCornerX, leftUpCornerY);
 }
 
 auto OnMouseMoved(double windowX, double windowY) {
@@ -49,49 +66,63 @@ auto OnMouseScrolled(double directionX, double directionY) {
 }
 
 auto OnMouseEnteredWindow(b8 entered) {
-    std::cout << (entered ? "MOUSE ENTERED" : "MOUSE LEFT") << std::endl;
+    DEI_LOG_INFO("%s\n", entered ? "MOUSE ENTERED" : "MOUSE LEFT");
 }
 
 auto OnMouseButton(MouseButton button, MouseButtonState state) {
     if (state == MouseButtonState::PRESS) {
-        printf("Press mouse %d\n", button);
+        DEI_LOG_INFO("Press mouse %d\n", button);
     }
 }
 
 auto OnKeyboardDefault(KeyCode key, KeyState state, const char* keyName) -> void {
     if (state == KeyState::PRESS) {
-        printf("Press key %s %d\n", keyName, key);
+        DEI_LOG_INFO("Press key %s %d\n", keyName, key);
     }
 }
 
 auto OnKeyboardR(KeyCode, KeyState state, const char*) -> void {
     if (state == KeyState::PRESS) {
-        printf("RRRRRRRRRRRRRRRRRRRRRRR\n");
+        DEI_LOG_DEBUG("RRRRRRRRRRRRRRRRRRRRRRR\n");
     }
 }
 
 auto OnWindowClosing() {
-    printf("GLFW Window closing\n");
+    DEI_LOG_INFO("GLFW Window closing\n");
 }
 
 auto OnWindowFocused(b8 isFocused) {
-    printf("Window focused: %d\n", isFocused);
+    DEI_LOG_INFO("Window focused: %d\n", isFocused);
 }
 
 auto OnWindowError(int code, const char* description) {
-    printf("Error GLFW %d: %s\n", code, description);
+    DEI_LOG_ERROR("GLFW %d: %s\n", code, description);
 }
 
 // args:
 // 1: install directory path (absolute)
 // 2: engine library basename (e.g. dei)
 // 3: frequency of hot reload (in draw calls)
+// 4: frame rate cap (in Hz, 0 - uncapped)
+// 5: simulation rate (in Hz)
+// 6: run the engine on a render thread, the main thread only handles window events (0 or 1)
+// 7: frame time budget (in ms, 0 - disabled), the latest frames are dumped to the install directory when exceeded
+// 8: idle behavior (0 - always render, 1 - throttle when unfocused or minimized, 2 - redraw on demand)
+// 9: buffered input, window events are queued for the engine (0 or 1), the host callbacks and key bindings are off then
 auto main(int argc, char *argv[]) -> int {
     // parse args
     assert(argc >= 3);
     u32 hotReloadFrequency = static_cast<u32>(argc >= 4 ? std::stoul(argv[3]) : 400UL);
-    constexpr double FPS_CAP = 300.0;
-    constexpr double TICK_CAP_SECONDS = 1.0 / FPS_CAP;
+    double fpsCap = argc >= 5 ? std::stod(argv[4]) : 300.0;
+    double simulationRate = argc >= 6 ? std::stod(argv[5]) : 60.0;
+    b8 useRenderThread = argc >= 7 ? std::stoul(argv[6]) != 0 : false;
+    f32 hitchBudgetMs = argc >= 8 ? std::stof(argv[7]) : 50.0f;
+    auto idleBehavior = static_cast<dei::platform::IdleBehavior>(argc >= 9 ? std::stoul(argv[8]) : 1UL);
+    b8 isInputBuffered = argc >= 10 ? std::stoul(argv[9]) != 0 : false;
+    u32 numFramesInFlight = static_cast<u32>(argc >= 11 ? std::stoul(argv[10]) : 2UL);
+
+    dei::platform::AllocationGuardSetMode(dei::platform::AllocationGuardModeFromEnvironment());
+    dei::platform::LogStart();
 
     // make window
     auto windowSystem = dei::platform::CreateWindowSystem(&OnWindowError);
@@ -109,9 +140,9 @@ auto main(int argc, char *argv[]) -> int {
     }
 
     auto startupClockCounter = dei::platform::GetClockCounter();
-    auto windowTitle = dei::platform::StringJoin("My window: #frame=1234567890 time=1234567890");
-    constexpr auto WINTITLE_FRAME_OFFSET = 18, WINTITLE_FRAME_SIZE = 10;
-    constexpr auto WINTITLE_TIME_OFFSET = 34, WINTITLE_TIME_SIZE = 10;
+    // rewritten in place, cheap enough to update every frame
+    auto windowTitle = dei::platform::FixedString<64>{};
+    dei::platform::FormatTo(windowTitle, DEI_FORMAT("My window: #frame={} time={:.1}"), 0u, 0.0);
 
     dei::platform::FullscreenMode windowFullscreenMode = dei::platform::FullscreenMode::WINDOWED;
     auto windowBuilder = dei::platform::WindowBuilder{};
@@ -119,7 +150,7 @@ auto main(int argc, char *argv[]) -> int {
         .WithVulkan(1, 3)
         .WithSize(800, 600)
         .WithSizeMin(200, 200)
-        .WithTitleUtf8(windowTitle.c_str())
+        .WithTitleUtf8(windowTitle.CStr())
         .WithInputTextCallback(&OnTextInput)
         .WithPositionCallback(&OnWindowMoved)
         .WithResizeCallback(&OnWindowResized)
@@ -128,6 +159,7 @@ auto main(int argc, char *argv[]) -> int {
         .WithFocusCallback(&OnWindowFocused)
         .WithScaleToMonitor(true)
         .WithRawMouseMotion(true)
+        .WithBufferedInput(isInputBuffered)
         .WithResizable(false)
         .WithColorBitDepth(32, 32, 32, 32)
         .WithFullscreen(windowFullscreenMode == dei::platform::FullscreenMode::FULLSCREEN ? primaryMonitor : nullptr, true)
@@ -151,6 +183,10 @@ auto main(int argc, char *argv[]) -> int {
     dei::platform::WindowSetIsFocusedAfterVisible(window, true);
     dei::platform::WindowSetIsResizable(window, true);
     dei::platform::WindowSetIsDecorated(window, true);
+    // the recorded frame index advances with the host frames, so only the single threaded loop can record
+    if (!useRenderThread) {
+        dei::platform::WindowStartInputRecordingFromEnvironment(window);
+    }
 
     {
         using namespace dei::platform;
@@ -192,6 +228,8 @@ auto main(int argc, char *argv[]) -> int {
             if (state != KeyState::PRESS) return;
             isVerticalSyncEnabled ^= 1;
             dei::platform::SetVerticalSync(windowSystem, isVerticalSyncEnabled);
+            dei::platform::WindowSetPresentPolicy(window, isVerticalSyncEnabled
+                ? dei::platform::PresentPolicy::VSYNC : dei::platform::PresentPolicy::LOW_LATENCY);
         }},
         {{KeyCode::KEY_C, MODIFIERS_ALT}, [&](KeyCode, KeyState state, const char*) {
             using dei::platform::input::CursorMode;
@@ -209,6 +247,10 @@ auto main(int argc, char *argv[]) -> int {
             dei::platform::WindowClearInput(window);
         }},
         {{KeyCode::BACKSPACE, MODIFIERS_NONE}, [&](KeyCode, KeyState state, const char*){
+            if (state != KeyState::PRESS) return;
+            dei::platform::WindowEraseInput(window);
+        }},
+        {{KeyCode::KEY_Z, MODIFIERS_CTRL}, [&](KeyCode, KeyState state, const char*){
             if (state != KeyState::PRESS) return;
             dei::platform::WindowUndoInput(window);
         }},
@@ -223,6 +265,9 @@ auto main(int argc, char *argv[]) -> int {
     auto engineHotReloader = cr_plugin{};
     auto engineLibPath = dei::platform::MakeLibraryFilepath(argv[1], argv[2]);
     assert(cr_plugin_open(engineHotReloader, engineLibPath.c_str())); // the full path to library
+    auto frameStats = dei::platform::FrameStats{};
+    auto latencyProbe = dei::platform::LatencyProbe{};
+    latencyProbe.Stats = &frameStats;
     auto engineDependencies = dei::EngineDependencies{};
     engineDependencies.RequiredHostExtensionCount = dei::platform::WindowVulkanGetRequiredExtensionsCount(window);
     engineDependencies.RequiredHostExtensions = dei::platform::WindowVulkanGetRequiredExtensions(window);
@@ -234,7 +279,17 @@ auto main(int argc, char *argv[]) -> int {
         }
         return *maybeSurface;
     };
-    auto engineHotReloadState = EngineHotReloadState{
+    engineDependencies.FrameStats = &frameStats;
+    engineDependencies.SimulationRateHz = simulationRate;
+    engineDependencies.InputEvents = dei::platform::WindowGetInputEventQueue(window);
+    engineDependencies.Input = &dei::platform::WindowGetInputSnapshot(window);
+    engineDependencies.MouseMotion = &dei::platform::WindowGetMouseMotion(window);
+    engineDependencies.WindowSurface = &dei::platform::WindowGetSurfaceState(window);
+    engineDependencies.NumFramesInFlight = numFramesInFlight;
+    engineDependencies.Latency = &latencyProbe;
+    // WindowBeginInputFrame runs on the main thread only, a render thread ticks on the live clock
+    engineDependencies.FrameNanosec = useRenderThread ? nullptr : &dei::platform::WindowGetFrameNanosec(window);
+    auto engineHotReloadState = dei::EngineHotReloadState{
         dei::EngineState{},
         engineDependencies,
     };
@@ -242,55 +297,227 @@ auto main(int argc, char *argv[]) -> int {
 
     printf("Hot-loadable library: %s\n", engineLibPath.c_str());
 
+#if DEI_PROFILER_ENABLED
+    auto traceFilepath = dei::platform::StringJoin(argv[1], "/dei_trace.json");
+    if (dei::platform::ProfilerStart(traceFilepath.c_str())) {
+        printf("Profiler trace: %s\n", traceFilepath.c_str());
+    }
+#endif
+
     // app loop
     b8 windowClosing{false}, engineClosing{false}, hotReloadCrashing{false};
     u32 updateWindowTitleEvery = 100;
-    auto beginTimeSeconds = dei::platform::GetTimeSec();
-    do {
-        dei::platform::PollWindowEvents(windowSystem);
+    auto framePacer = dei::platform::CreateFramePacer(fpsCap);
+    // large, so not on the stack
+    auto flightRecorder = std::make_unique<dei::platform::FlightRecorder>();
+    dei::platform::FlightRecorderConfigure(*flightRecorder, argv[1], hitchBudgetMs);
+    u64 lastEventCount = 0, lastSimulationSteps = 0, lastAllocationCount = 0, lastLatencySamples = 0;
+    // live counters for external tools, see MetricsPage.hpp for the layout
+    constexpr i64 METRICS_PUBLISH_PERIOD_NANOSEC = 100000000LL;
+    auto metricsPublisher = dei::platform::CreateMetricsPublisher("dei_metrics");
+    if (metricsPublisher) {
+        printf("Metrics page: /dev/shm%s\n", metricsPublisher->Name.c_str());
+    }
+    auto metrics = dei::platform::MetricsSnapshot{};
+    u32 lastHotReloadVersion = 0;
+    auto idlePolicy = dei::platform::CreateIdlePolicy(idleBehavior, fpsCap);
+    // decided on the main thread, read by the render thread, which sleeps on idleModeChanged while not rendering
+    std::atomic<dei::platform::IdleMode> publishedIdleMode{dei::platform::IdleMode::ACTIVE};
+    std::mutex idleModeMutex;
+    std::condition_variable idleModeChanged;
+    auto publishIdleMode = [&](dei::platform::IdleMode idleMode) {
+        auto isClosing = dei::platform::WindowIsClosing(window);
+        {
+            // under the lock, so the render thread can't miss it between its check and its wait
+            std::lock_guard<std::mutex> lock{idleModeMutex};
+            if (publishedIdleMode.exchange(idleMode, std::memory_order_relaxed) == idleMode && !isClosing) {
+                return;
+            }
+        }
+        idleModeChanged.notify_one();
+    };
+    auto currentIdleMode = dei::platform::IdleMode::ACTIVE;
+    auto applyIdleMode = [&](dei::platform::IdleMode idleMode) {
+        if (idleMode == currentIdleMode) {
+            return;
+        }
+        DEI_LOG_INFO("Idle mode: %s\n", dei::platform::IdleModeToStr(idleMode));
+        currentIdleMode = idleMode;
+        dei::platform::FramePacerSetTargetRate(framePacer,
+            dei::platform::IdlePolicyTargetRate(idlePolicy, idleMode));
+    };
+    // the only engine data read by the main thread when the render thread is used
+    std::atomic<u32> publishedDrawCounter{0};
+    auto updateWindowTitle = [&](u32 drawCounter) {
+        auto timeSec = static_cast<f64>(dei::platform::GetClockCounter() - startupClockCounter)
+            / static_cast<f64>(dei::platform::GetClockFrequencyHertz());
+        dei::platform::FormatTo(windowTitle, DEI_FORMAT("My window: #frame={} time={:.1}"), drawCounter, timeSec);
+        dei::platform::WindowSetTitleUtf8(window, windowTitle.CStr());
+    };
+    // events and window title are main thread only, with the render thread they are handled outside
+    auto runFrame = [&](b8 isMainThread) -> b8 {
+        // block here while nothing needs to be rendered
+        if (isMainThread) {
+            auto idleMode = dei::platform::IdlePolicyUpdate(idlePolicy, window);
+            while (!dei::platform::IdleModeIsRendering(idleMode) && !dei::platform::WindowIsClosing(window)) {
+                dei::platform::WaitWindowEvents(windowSystem, idlePolicy.IdleWaitSec);
+                idleMode = dei::platform::IdlePolicyUpdate(idlePolicy, window);
+            }
+            applyIdleMode(idleMode);
+        } else {
+            auto lock = std::unique_lock<std::mutex>{idleModeMutex};
+            idleModeChanged.wait(lock, [&]() {
+                return dei::platform::IdleModeIsRendering(publishedIdleMode.load(std::memory_order_relaxed))
+                    || dei::platform::WindowIsClosing(window);
+            });
+            auto idleMode = publishedIdleMode.load(std::memory_order_relaxed);
+            lock.unlock();
+            applyIdleMode(idleMode);
+        }
+        DEI_PROFILE_SCOPE("Frame");
+        auto allocationTag = dei::platform::AllocationTagScope{dei::platform::AllocationTag::HOST};
+        using dei::platform::FramePhase;
+        dei::platform::FrameStatsBeginFrame(frameStats);
+        if (isMainThread) {
+            dei::platform::PollWindowEvents(windowSystem);
+            dei::platform::WindowBeginInputFrame(window);
+        }
+        dei::platform::WindowLatchInputState(window);
+        auto latencyFrameId = dei::platform::LatencyProbeBeginFrame(latencyProbe,
+            dei::platform::WindowTakeInputTimestamp(window));
+        dei::platform::FrameStatsEndPhase(frameStats, FramePhase::POLL_EVENTS);
         auto drawCounter = engineHotReloadState.EngineState.DrawCounter;
-        if (drawCounter % updateWindowTitleEvery == 0) {
-            auto&& drawCounterStr = std::to_string(drawCounter);
-            dei::platform::SetSubstringInplace(windowTitle,
-                drawCounterStr.c_str(), WINTITLE_FRAME_OFFSET, WINTITLE_FRAME_SIZE, ' ');
-            auto&& timeSecStr = std::to_string(
-                (dei::platform::GetClockCounter() - startupClockCounter) / dei::platform::GetClockFrequencyHertz());
-            dei::platform::SetSubstringInplace(windowTitle,
-                timeSecStr.c_str(), WINTITLE_TIME_OFFSET, WINTITLE_TIME_SIZE, ' ');
-            dei::platform::WindowSetTitleUtf8(window, windowTitle.c_str());
+        publishedDrawCounter.store(drawCounter, std::memory_order_relaxed);
+        if (isMainThread && drawCounter % updateWindowTitleEvery == 0) {
+            updateWindowTitle(drawCounter);
         }
+        dei::platform::FrameStatsEndPhase(frameStats, FramePhase::TITLE_UPDATE);
+        int engineAnswer = 0;
         {
+            DEI_PROFILE_SCOPE("cr_plugin_update");
             auto doReloadCheck = (drawCounter % hotReloadFrequency) == 0;
-            auto engineAnswer = cr_plugin_update(engineHotReloader, doReloadCheck);
+            engineAnswer = cr_plugin_update(engineHotReloader, doReloadCheck);
             switch (engineAnswer) {
                 case 0: break;
-                case -1: printf("dei::cr::ERROR_UPDATE\n"); hotReloadCrashing = true; break;
-                case -2: printf("dei::cr::ERROR_LOAD_UNLOAD=-2\n"); hotReloadCrashing = true; break;
-                default: printf("dei::cr::answer=%d\n", engineAnswer); engineClosing = true; break;
+                case -1: DEI_LOG_ERROR("dei::cr::ERROR_UPDATE\n"); hotReloadCrashing = true; break;
+                case -2: DEI_LOG_ERROR("dei::cr::ERROR_LOAD_UNLOAD=-2\n"); hotReloadCrashing = true; break;
+                default: DEI_LOG_INFO("dei::cr::answer=%d\n", engineAnswer); engineClosing = true; break;
+            }
+            // cr rolls back at the start of the next update and unloads the failed library without calling
+            // into it, the records it queued point to its format strings, format them while it's still loaded
+            if (engineHotReloader.failure != CR_NONE) {
+                dei::platform::LogFlush();
             }
         }
+        dei::platform::FrameStatsEndPhase(frameStats, FramePhase::ENGINE_TICK);
 
         dei::platform::WindowSwapBuffers(window);
+        if (!latencyProbe.IsReportedByRenderer) {
+            // no swapchain (yet), the frame counts as presented once the buffers are swapped
+            dei::platform::LatencyProbePresentFrame(latencyProbe, latencyFrameId, dei::platform::GetMonotonicNanosec());
+        }
+        // with a swapchain, the samples are of earlier frames the GPU has finished meanwhile
+        auto inputToPhotonMs = latencyProbe.NumSamples != lastLatencySamples ? latencyProbe.LastSampleMs : 0.0f;
+        lastLatencySamples = latencyProbe.NumSamples;
         windowClosing = dei::platform::WindowIsClosing(window);
+        dei::platform::FrameStatsEndPhase(frameStats, FramePhase::SWAP_BUFFERS);
+
+        dei::platform::FramePacerWait(framePacer);
+        dei::platform::FrameStatsEndPhase(frameStats, FramePhase::PACING_SLEEP);
+        dei::platform::FrameStatsEndFrame(frameStats);
+
+        auto& flightRecord = dei::platform::FlightRecorderRecordFrame(*flightRecorder, frameStats);
+        flightRecord.PhaseMs[static_cast<u32>(FramePhase::INPUT_TO_PHOTON)] = inputToPhotonMs;
+        auto eventCount = dei::platform::WindowGetEventCount(window);
+        auto simulationSteps = engineHotReloadState.EngineState.Timestep.NumSteps;
+        auto allocationCount = dei::platform::AllocationGetTotalCount();
+        flightRecord.NumEvents = static_cast<u32>(eventCount - lastEventCount);
+        flightRecord.NumSimulationSteps = static_cast<u32>(simulationSteps - lastSimulationSteps);
+        flightRecord.NumAllocations = static_cast<u32>(allocationCount - lastAllocationCount);
+        flightRecord.HotReloadVersion = engineHotReloader.version;
+        flightRecord.HotReloadFailure = static_cast<i32>(engineHotReloader.failure);
+        flightRecord.HotReloadAnswer = engineAnswer;
+        lastEventCount = eventCount;
+        lastSimulationSteps = simulationSteps;
+        lastAllocationCount = allocationCount;
+        dei::platform::FlightRecorderEndFrame(*flightRecorder);
+
+        if (engineHotReloader.version != lastHotReloadVersion) {
+            metrics.NumReloads += lastHotReloadVersion != 0;
+            lastHotReloadVersion = engineHotReloader.version;
+        }
+        metrics.NumReloadFailures += engineAnswer < 0;
+        if (metricsPublisher && frameStats.FrameBeginNanosec - metrics.PublishNanosec >= METRICS_PUBLISH_PERIOD_NANOSEC) {
+            using dei::platform::FramePhase;
+            auto frame = dei::platform::FrameStatsQuery(frameStats, FramePhase::FRAME_TOTAL);
+            auto tick = dei::platform::FrameStatsQuery(frameStats, FramePhase::ENGINE_TICK);
+            metrics.PublishNanosec = frameStats.FrameBeginNanosec;
+            metrics.FrameIndex = flightRecorder->NumFrames;
+            metrics.DrawCounter = engineHotReloadState.EngineState.DrawCounter;
+            metrics.FrameLastMs = frame.LastMs;
+            metrics.FrameP50Ms = frame.P50Ms;
+            metrics.FrameP99Ms = frame.P99Ms;
+            metrics.FrameMaxMs = frame.MaxMs;
+            metrics.TickLastMs = tick.LastMs;
+            metrics.TickP50Ms = tick.P50Ms;
+            metrics.TickP99Ms = tick.P99Ms;
+            metrics.TickMaxMs = tick.MaxMs;
+            metrics.ResidentBytes = dei::platform::GetResidentBytes();
+            metrics.NumAllocations = allocationCount;
+            auto vulkanAllocations = dei::platform::VulkanAllocatorQueryStats();
+            metrics.VulkanLiveBytes = vulkanAllocations.LiveBytes;
+            metrics.VulkanInternalBytes = vulkanAllocations.InternalBytes;
+            dei::platform::MetricsPublish(*metricsPublisher, metrics);
+        }
+        return !(windowClosing || engineClosing || hotReloadCrashing);
+    };
 
-        auto nowSeconds = dei::platform::GetTimeSec();
-        auto deltaSeconds = nowSeconds - beginTimeSeconds;
-        if (deltaSeconds < TICK_CAP_SECONDS) {
-            auto remainingMillisec = static_cast<u32>(1000.0*(TICK_CAP_SECONDS - deltaSeconds)) ;
-            if (remainingMillisec > 0) {
-                dei::platform::ThreadSleepMs(remainingMillisec);
+    if (useRenderThread) {
+        // the render thread owns the engine from the first update (so VkSurfaceKHR is created there)
+        // to the last one, the main thread owns the window and only pumps its events
+        std::atomic<b8> isRendering{true};
+        auto renderThread = std::thread{[&]() {
+            dei::platform::LogRegisterThread();
+            while (runFrame(false)) {}
+            isRendering.store(false, std::memory_order_release);
+            dei::platform::WakeWindowEvents(windowSystem);
+        }};
+        u32 lastTitleDrawCounter = 0;
+        while (isRendering.load(std::memory_order_acquire)) {
+            dei::platform::WaitWindowEvents(windowSystem, 0.1);
+            publishIdleMode(dei::platform::IdlePolicyUpdate(idlePolicy, window));
+            auto drawCounter = publishedDrawCounter.load(std::memory_order_relaxed);
+            if (drawCounter - lastTitleDrawCounter >= updateWindowTitleEvery) {
+                lastTitleDrawCounter = drawCounter;
+                updateWindowTitle(drawCounter);
             }
         }
-
-        nowSeconds = dei::platform::GetTimeSec();
-        deltaSeconds = nowSeconds - beginTimeSeconds;
-        beginTimeSeconds = nowSeconds;
-    } while(!(windowClosing || engineClosing || hotReloadCrashing));
+        renderThread.join();
+    } else {
+        while (runFrame(true)) {}
+    }
+    // a hitch dump may still be in flight, its writer logs
+    dei::platform::FlightRecorderStop(*flightRecorder);
+    // the summary below goes straight to stdout, after everything logged before it
+    dei::platform::LogStop();
 
     printf("windowClose=%d engineClose=%d hotReloadCrash=%d\n", windowClosing, engineClosing, hotReloadCrashing);
+    auto pacerStats = dei::platform::FramePacerGetStats(framePacer);
+    printf("Frame pacing: target=%.1f Hz frames=%lu missed=%lu jitter mean=%.1f us stddev=%.1f us max=%.1f us (spin %.1f us)\n",
+        fpsCap, pacerStats.NumFrames, pacerStats.NumMissedDeadlines,
+        pacerStats.JitterMeanMicrosec, pacerStats.JitterStdDevMicrosec,
+        pacerStats.JitterMaxMicrosec, pacerStats.SpinThresholdMicrosec);
+    dei::platform::PrintFrameStats(frameStats);
+    dei::platform::PrintAllocationStats();
 
     // tear down hot reloading
     cr_plugin_close(engineHotReloader);
+    // after the engine destroyed its Vulkan objects, whatever is still live leaked
+    dei::platform::PrintVulkanAllocationStats();
+    dei::platform::ProfilerStop();
+    if (metricsPublisher) {
+        dei::platform::DestroyMetricsPublisher(*metricsPublisher);
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "dei_platform/Time.hpp"
+
+#include "dei/GpuMemory.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+using dei::render::GPU_MEMORY_BLOCK_BYTES;
+
+struct Device {
+    VkInstance instance;
+    VkPhysicalDevice physicalDevice;
+    VkDevice device;
+};
+
+// no surface and no extensions, the allocator only needs vkAllocateMemory
+auto CreateDevice() -> std::optional<Device> {
+    auto result = Device{};
+    auto appInfo = VkApplicationInfo{};
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.pApplicationName = "dei gpu memory bench";
+    appInfo.apiVersion = VK_API_VERSION_1_2;
+    auto instanceInfo = VkInstanceCreateInfo{};
+    instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.pApplicationInfo = &appInfo;
+    if (vkCreateInstance(&instanceInfo, nullptr, &result.instance) != VK_SUCCESS) {
+        return std::nullopt;
+    }
+    auto numPhysicalDevices = u32{1};
+    auto status = vkEnumeratePhysicalDevices(result.instance, &numPhysicalDevices, &result.physicalDevice);
+    if ((status != VK_SUCCESS && status != VK_INCOMPLETE) || numPhysicalDevices == 0) {
+        vkDestroyInstance(result.instance, nullptr);
+        return std::nullopt;
+    }
+    constexpr f32 QUEUE_PRIORITY = 1.0f;
+    auto queueInfo = VkDeviceQueueCreateInfo{};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = 0;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &QUEUE_PRIORITY;
+    auto deviceInfo = VkDeviceCreateInfo{};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    if (vkCreateDevice(result.physicalDevice, &deviceInfo, nullptr, &result.device) != VK_SUCCESS) {
+        vkDestroyInstance(result.instance, nullptr);
+        return std::nullopt;
+    }
+    return result;
+}
+
+// deterministic, so every run checks the same pattern
+struct Random {
+    auto Next() -> u32 {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<u32>(state >> 33);
+    }
+    u64 state;
+};
+
+// mostly small buffers, some up to a few MiB, alignments from 1 byte to 64 KiB
+auto MakeRequirements(Random& random) -> VkMemoryRequirements {
+    auto requirements = VkMemoryRequirements{};
+    auto sizeShift = random.Next() % 100 < 90 ? random.Next() % 17 : 17 + random.Next() % 6;
+    requirements.size = (VkDeviceSize{1} << sizeShift) + random.Next() % (VkDeviceSize{1} << sizeShift);
+    requirements.alignment = VkDeviceSize{1} << (random.Next() % 17);
+    requirements.memoryTypeBits = ~0u;
+    return requirements;
+}
+
+auto CheckAllocation(const dei::render::GpuAllocation& allocation, const VkMemoryRequirements& requirements) -> void {
+    assert(allocation.offset % requirements.alignment == 0);
+    assert(allocation.size == requirements.size);
+    assert(allocation.isDedicated || allocation.offset + allocation.size <= GPU_MEMORY_BLOCK_BYTES);
+    (void)allocation;
+    (void)requirements;
+}
+
+// no two live allocations of one VkDeviceMemory overlap
+auto CheckDisjoint(std::vector<dei::render::GpuAllocation> allocations) -> void {
+    std::sort(allocations.begin(), allocations.end(), [](const auto& a, const auto& b) {
+        return a.memory != b.memory ? a.memory < b.memory : a.offset < b.offset;
+    });
+    for (size_t i = 1; i < allocations.size(); ++i) {
+        const auto& previous = allocations[i - 1];
+        assert(previous.memory != allocations[i].memory || previous.offset + previous.size <= allocations[i].offset);
+        (void)previous;
+    }
+}
+
+template<typename Fn>
+auto MeasureNanosec(Fn&& fn) -> i64 {
+    auto begin = dei::platform::GetMonotonicNanosec();
+    fn();
+    return dei::platform::GetMonotonicNanosec() - begin;
+}
+
+} // namespace ::
+
+// Checks the buddy allocator of GpuMemory on a real device: a mixed-size pattern is allocated, half of it freed
+// and allocated again, then everything is freed in random order, the blocks must merge back whole.
+// Prints results as JSON, fails an assert on a broken invariant. Works on a software Vulkan driver (lavapipe).
+// args:
+// 1: number of live allocations (default 2000)
+// 2: number of rounds (default 4)
+auto main(int argc, char *argv[]) -> int {
+    auto numAllocations = static_cast<u32>(argc >= 2 ? std::stoul(argv[1]) : 2000UL);
+    auto numRounds = static_cast<u32>(argc >= 3 ? std::stoul(argv[2]) : 4UL);
+    auto maybeDevice = ::CreateDevice();
+    if (maybeDevice == std::nullopt) {
+        fprintf(stderr, "No Vulkan device\n");
+        return 1;
+    }
+    auto device = *maybeDevice;
+    auto memory = dei::render::CreateGpuMemory(device.physicalDevice, device.device);
+
+    auto random = Random{ 0x5eed };
+    auto allocations = std::vector<dei::render::GpuAllocation>{};
+    auto requirements = std::vector<VkMemoryRequirements>{};
+    allocations.reserve(numAllocations);
+    requirements.reserve(numAllocations);
+    u64 numAllocated = 0, numFreed = 0;
+    i64 allocateNanosec = 0, freeNanosec = 0;
+    auto allocate = [&]() {
+        auto required = ::MakeRequirements(random);
+        std::optional<dei::render::GpuAllocation> allocation;
+        allocateNanosec += ::MeasureNanosec([&]() {
+            allocation = dei::render::GpuMemoryAllocate(memory, required, 0,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, dei::render::GpuResourceKind::LINEAR);
+        });
+        assert(allocation != std::nullopt);
+        ::CheckAllocation(*allocation, required);
+        allocations.push_back(*allocation);
+        requirements.push_back(required);
+        ++numAllocated;
+    };
+    auto freeAt = [&](size_t index) {
+        freeNanosec += ::MeasureNanosec([&]() { dei::render::GpuMemoryFree(memory, allocations[index]); });
+        allocations[index] = allocations.back();
+        allocations.pop_back();
+        requirements[index] = requirements.back();
+        requirements.pop_back();
+        ++numFreed;
+    };
+
+    auto maxBlocks = u32{0};
+    auto maxFragmentation = 0.0f;
+    for (u32 round = 0; round < numRounds; ++round) {
+        while (allocations.size() < numAllocations) {
+            allocate();
+        }
+        ::CheckDisjoint(allocations);
+        // holes all over the blocks
+        for (size_t i = 0; i < allocations.size(); ++i) {
+            if (random.Next() % 2 == 0) {
+                freeAt(i);
+            }
+        }
+        auto stats = dei::render::GpuMemoryQueryStats(memory, dei::render::NO_MEMORY_TYPE);
+        maxBlocks = std::max(maxBlocks, stats.numBlocks);
+        maxFragmentation = std::max(maxFragmentation, stats.fragmentation);
+        while (allocations.size() < numAllocations) {
+            allocate();
+        }
+        ::CheckDisjoint(allocations);
+    }
+    while (!allocations.empty()) {
+        freeAt(random.Next() % allocations.size());
+    }
+
+    // every buddy merged back into a whole block
+    auto stats = dei::render::GpuMemoryQueryStats(memory, dei::render::NO_MEMORY_TYPE);
+    assert(stats.numAllocations == 0);
+    assert(stats.usedBytes == 0);
+    assert(stats.numBlocks > 0 && stats.largestFreeBytes == GPU_MEMORY_BLOCK_BYTES);
+    assert(stats.fragmentation == 0.0f);
+
+    printf("{\"benchmark\":\"gpu_memory\",\"allocations\":%lu,\"frees\":%lu,\"max_blocks\":%u,"
+        "\"max_fragmentation\":%.3f,\"allocate_ns\":%.1f,\"free_ns\":%.1f}\n",
+        numAllocated, numFreed, maxBlocks, static_cast<f64>(maxFragmentation),
+        static_cast<f64>(allocateNanosec) / static_cast<f64>(numAllocated),
+        static_cast<f64>(freeNanosec) / static_cast<f64>(numFreed));
+
+    dei::render::DestroyGpuMemory(memory);
+    vkDestroyDevice(device.device, nullptr);
+    vkDestroyInstance(device.instance, nullptr);
+    return 0;
+}
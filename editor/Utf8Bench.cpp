@@ -0,0 +1,153 @@
+#include "dei_platform/Utf8.hpp"
+#include "dei_platform/Time.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <locale>
+#include <string>
+#include <vector>
+
+namespace {
+
+// the std::codecvt facet path the engine used before dei_platform/Utf8.hpp, kept as the baseline
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+template<class Facet>
+struct DeletableFacet : Facet {
+    template<class... Args>
+    DeletableFacet(Args&&... args) : Facet(std::forward<Args>(args)...) {}
+    ~DeletableFacet() {}
+};
+
+struct FacetAppendToUtf8 {
+    auto operator()(std::string& dest, u32 codepoint) -> b8 {
+        auto source = static_cast<char32_t>(codepoint);
+        const auto* sourceNext = &source;
+        char buffer[4];
+        char* destNext = buffer;
+        std::mbstate_t state{};
+        auto convOut = conv.out(state, &source, &source + 1, sourceNext, buffer, buffer + sizeof(buffer), destNext);
+        if (convOut != std::codecvt_base::result::ok || destNext <= buffer) {
+            return false;
+        }
+        dest.append(buffer, static_cast<size_t>(destNext - buffer));
+        return true;
+    }
+    DeletableFacet<std::codecvt<char32_t, char, std::mbstate_t>> conv;
+};
+
+auto FacetConvertUtf32ToUtf8(const std::u32string& source) -> std::string {
+    std::wstring_convert<DeletableFacet<std::codecvt<char32_t, char, std::mbstate_t>>, char32_t> conv;
+    return conv.to_bytes(source);
+}
+#pragma clang diagnostic pop
+
+// mostly ASCII with runs of Cyrillic, CJK and emoji, like the text typed or pasted into an editor
+auto MakeCorpus(size_t numCodepoints) -> std::u32string {
+    const char32_t* pieces[] = {
+        U"The quick brown fox jumps over the lazy dog. ",
+        U"Съешь же ещё этих мягких французских булок. ",
+        U"float4 position = mul(viewProjection, worldPosition); ",
+        U"速い茶色の狐がのろまな犬を飛び越える。",
+        U"\U0001F680\U0001F525 ",
+        U"  // TODO: check the swapchain extent\n",
+    };
+    auto corpus = std::u32string{};
+    for (u32 i = 0; corpus.size() < numCodepoints; ++i) {
+        corpus += pieces[(i * 7) % (sizeof(pieces) / sizeof(pieces[0]))];
+    }
+    corpus.resize(numCodepoints);
+    return corpus;
+}
+
+template<typename Fn>
+auto MeasureMs(u32 numRepeats, Fn&& fn) -> f64 {
+    auto bestNanosec = INT64_MAX;
+    for (u32 i = 0; i < numRepeats; ++i) {
+        auto begin = dei::platform::GetMonotonicNanosec();
+        fn();
+        bestNanosec = std::min(bestNanosec, dei::platform::GetMonotonicNanosec() - begin);
+    }
+    return static_cast<f64>(bestNanosec) * 1e-6;
+}
+
+auto PrintResult(const char* name, f64 ms, size_t numBytes) -> void {
+    printf(",\"%s\":{\"ms\":%.3f,\"mb_per_s\":%.1f}", name, ms,
+        static_cast<f64>(numBytes) / (ms * 1e-3) / (1024.0 * 1024.0));
+}
+
+} // namespace ::
+
+// Compares the UTF-8 paths against the old std::codecvt one, prints results as JSON.
+// args:
+// 1: number of codepoints in the text (default 1M)
+// 2: number of repeats, the best is reported
+auto main(int argc, char *argv[]) -> int {
+    using dei::platform::SimdLevel;
+    auto numCodepoints = static_cast<size_t>(argc >= 2 ? std::stoul(argv[1]) : 1UL << 20);
+    auto numRepeats = static_cast<u32>(argc >= 3 ? std::stoul(argv[2]) : 10UL);
+    auto corpus = ::MakeCorpus(numCodepoints);
+    auto expectedUtf8 = ::FacetConvertUtf32ToUtf8(corpus);
+    auto utf8 = std::string{};
+    auto utf32 = std::u32string{};
+    utf8.reserve(corpus.size() * 4);
+    utf32.reserve(corpus.size());
+
+    printf("{\"benchmark\":\"utf8\",\"codepoints\":%zu,\"utf8_bytes\":%zu,\"simd\":%u",
+        corpus.size(), expectedUtf8.size(), static_cast<u32>(dei::platform::Utf8GetSimdLevel()));
+
+    auto facet = FacetAppendToUtf8{};
+    auto ms = ::MeasureMs(numRepeats, [&]{
+        utf8.clear();
+        for (auto codepoint : corpus) {
+            facet(utf8, codepoint);
+        }
+    });
+    assert(utf8 == expectedUtf8);
+    ::PrintResult("encode_per_codepoint_facet", ms, expectedUtf8.size());
+
+    ms = ::MeasureMs(numRepeats, [&]{
+        utf8.clear();
+        for (auto codepoint : corpus) {
+            dei::platform::AppendUtf8(utf8, codepoint);
+        }
+    });
+    assert(utf8 == expectedUtf8);
+    ::PrintResult("encode_per_codepoint", ms, expectedUtf8.size());
+
+    ms = ::MeasureMs(numRepeats, [&]{ utf8 = ::FacetConvertUtf32ToUtf8(corpus); });
+    ::PrintResult("encode_bulk_facet", ms, expectedUtf8.size());
+
+    const char* levelNames[] = { "scalar", "sse2", "avx2" };
+    for (u32 level = 0; level < 3; ++level) {
+        dei::platform::Utf8ForceSimdLevel(static_cast<SimdLevel>(level));
+        if (static_cast<u32>(dei::platform::Utf8GetSimdLevel()) != level) {
+            continue;
+        }
+        auto name = std::string{"encode_bulk_"} + levelNames[level];
+        ms = ::MeasureMs(numRepeats, [&]{
+            utf8.clear();
+            dei::platform::AppendUtf32AsUtf8(utf8, corpus);
+        });
+        assert(utf8 == expectedUtf8);
+        ::PrintResult(name.c_str(), ms, expectedUtf8.size());
+
+        name = std::string{"decode_bulk_"} + levelNames[level];
+        ms = ::MeasureMs(numRepeats, [&]{
+            utf32.clear();
+            dei::platform::AppendUtf8AsUtf32(utf32, expectedUtf8);
+        });
+        assert(utf32 == corpus);
+        ::PrintResult(name.c_str(), ms, expectedUtf8.size());
+
+        name = std::string{"validate_"} + levelNames[level];
+        b8 isValid = false;
+        ms = ::MeasureMs(numRepeats, [&]{ isValid = dei::platform::Utf8Validate(expectedUtf8); });
+        assert(isValid);
+        ::PrintResult(name.c_str(), ms, expectedUtf8.size());
+    }
+    printf("}\n");
+    return 0;
+}
@@ -1,28 +1,126 @@
 #include "dei/Entry.hpp"
 #include "dei/Vulkan.hpp"
+#include "dei/Swapchain.hpp"
+#include "dei/Upload.hpp"
 #include "dei/Camera.hpp"
 #include "dei_platform/TypesVec.hpp"
 #include "dei_platform/TypesMat.hpp"
+#include "dei_platform/FrameStats.hpp"
+#include "dei_platform/Time.hpp"
+#include "dei_platform/Profiler.hpp"
+#include "dei_platform/Log.hpp"
+#include "dei_platform/Allocation.hpp"
+#include "dei_platform/VulkanAllocator.hpp"
+#include "dei_platform/InputEvents.hpp"
+#include "dei_platform/InputState.hpp"
 
-#include <iostream>
+#include <glm/common.hpp>
+#include <glm/gtc/constants.hpp>
+
+#include <algorithm>
+#include <cmath>
 
 namespace {
 
+constexpr u32 FRAME_STATS_REPORT_EVERY = 5000;
+// after this many ticks the tick must not allocate (checked when the allocation guard is on)
+constexpr u32 ALLOCATION_GUARD_WARMUP_TICKS = 120;
+constexpr f32 CAMERA_ORBIT_RAD_PER_SEC = 0.5f;
+constexpr f32 CAMERA_INITIAL_DISTANCE = -5.0f;
+constexpr f32 CAMERA_DISTANCE_MIN = -50.0f;
+constexpr f32 CAMERA_DISTANCE_MAX = -1.0f;
+constexpr f32 CAMERA_ZOOM_PER_SCROLL = 0.5f;
+constexpr f32 CAMERA_ZOOM_PER_SEC = 5.0f;
+constexpr f32 CAMERA_LOOK_RAD_PER_PIXEL = 0.003f;
+constexpr f32 CAMERA_PITCH_LIMIT_RAD = 1.5f;
+
+void ReportFrameStats(const dei::platform::FrameStats& frameStats) {
+    using dei::platform::FramePhase;
+    auto tick = dei::platform::FrameStatsQuery(frameStats, FramePhase::ENGINE_TICK);
+    auto frame = dei::platform::FrameStatsQuery(frameStats, FramePhase::FRAME_TOTAL);
+    DEI_LOG_INFO("Frame stats: tick p50=%.3f p99=%.3f max=%.3f ms, frame p50=%.3f p99=%.3f max=%.3f ms\n",
+        static_cast<f64>(tick.P50Ms), static_cast<f64>(tick.P99Ms), static_cast<f64>(tick.MaxMs),
+        static_cast<f64>(frame.P50Ms), static_cast<f64>(frame.P99Ms), static_cast<f64>(frame.MaxMs));
+    auto inputToPhoton = dei::platform::FrameStatsQuery(frameStats, FramePhase::INPUT_TO_PHOTON);
+    if (inputToPhoton.NumSamples > 0) {
+        DEI_LOG_INFO("Input to photon: p50=%.3f p99=%.3f max=%.3f ms (%u samples)\n",
+            static_cast<f64>(inputToPhoton.P50Ms), static_cast<f64>(inputToPhoton.P99Ms),
+            static_cast<f64>(inputToPhoton.MaxMs), inputToPhoton.NumSamples);
+    }
+}
+
+void ReportVulkanAllocations() {
+    auto stats = dei::platform::VulkanAllocatorQueryStats();
+    u64 liveBytes[dei::platform::VULKAN_ALLOCATION_SCOPE_COUNT];
+    for (u32 scope = 0; scope < dei::platform::VULKAN_ALLOCATION_SCOPE_COUNT; ++scope) {
+        liveBytes[scope] = stats.Scopes[scope].LiveBytes;
+    }
+    DEI_LOG_INFO("Vulkan host memory: live command=%lu object=%lu cache=%lu device=%lu instance=%lu internal=%lu bytes, "
+        "arena overflows=%lu\n", liveBytes[0], liveBytes[1], liveBytes[2], liveBytes[3], liveBytes[4],
+        stats.InternalBytes, stats.NumArenaOverflows);
+}
+
+void DrainInputEvents(dei::EngineState& engineState, dei::platform::input::InputEventQueue& inputEvents) {
+    using dei::platform::input::InputEvent;
+    using dei::platform::input::InputEventType;
+    engineState.NumInputEventsLastTick = dei::platform::input::InputEventQueueDrain(inputEvents,
+        [&](const InputEvent& event) {
+            using dei::platform::input::MouseButton;
+            if (event.Type == InputEventType::MOUSE_BUTTON
+                && event.Code == static_cast<i32>(MouseButton::MIDDLE) && event.Action == GLFW_PRESS) {
+                engineState.CurrentSimulation.CameraDistance = ::CAMERA_INITIAL_DISTANCE;
+                engineState.PreviousSimulation.CameraDistance = ::CAMERA_INITIAL_DISTANCE;
+            }
+        });
+}
+
+// the placeholder of a render pass: clears the acquired swapchain image and hands it to presentation
+void RecordClearPass(VkCommandBuffer commandBuffer, VkImage image, const VkClearColorValue& color) {
+    auto range = VkImageSubresourceRange{};
+    range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    range.baseMipLevel = 0;
+    range.levelCount = 1;
+    range.baseArrayLayer = 0;
+    range.layerCount = 1;
+    auto barrier = VkImageMemoryBarrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = nullptr;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    // the previous contents are discarded
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange = range;
+    // waits for the acquire semaphore, which the submit waits on at the transfer stage
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+    vkCmdClearColorImage(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1, &range);
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
 void RunSandboxLogic() {
     auto extensionCount = u32{0};
     vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
-    std::cout << extensionCount << " extensions supported\n";
+    DEI_LOG_DEBUG("%u extensions supported\n", extensionCount);
     std::vector<VkExtensionProperties> availableExtensions(extensionCount);
     vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, availableExtensions.data());
-    std::cout << "Supported extensions:" << std::endl;
+    DEI_LOG_DEBUG("Supported extensions:\n");
     for (const auto& extension : availableExtensions) {
-        std::cout << "\t" << extension.extensionName << std::endl;
+        DEI_LOG_DEBUG("\t%s\n", extension.extensionName);
     }
     auto c = dei::MakeCamera(-5.0f, dei::vec2f{0.0f, 0.0f});
-    std::cout << c[0][0] << ' ' << c[0][1] << ' ' << c[0][2] << ' ' << c[0][3] << '\n';
-    std::cout << c[1][0] << ' ' << c[1][1] << ' ' << c[1][2] << ' ' << c[1][3] << '\n';
-    std::cout << c[2][0] << ' ' << c[2][1] << ' ' << c[2][2] << ' ' << c[2][3] << '\n';
-    std::cout << c[3][0] << ' ' << c[3][1] << ' ' << c[3][2] << ' ' << c[3][3] << '\n';
+    for (i32 row = 0; row < 4; ++row) {
+        DEI_LOG_DEBUG("%g %g %g %g\n", static_cast<f64>(c[row][0]), static_cast<f64>(c[row][1]),
+            static_cast<f64>(c[row][2]), static_cast<f64>(c[row][3]));
+    }
 }
 
 }
@@ -30,21 +128,25 @@ void RunSandboxLogic() {
 namespace dei {
 
 b8 EngineColdStartup(EngineState& destinationState, const EngineDependencies& dependencies) {
+    DEI_PROFILE_SCOPE("EngineColdStartup");
+    auto allocationTag = platform::AllocationTagScope{platform::AllocationTag::RENDER};
     auto vkInstance = dei::render::CreateVulkanInstance(
         dependencies.RequiredHostExtensions,
         dependencies.RequiredHostExtensionCount);
     if (vkInstance == VK_NULL_HANDLE) {
       return false;
     }
+    auto& vulkan = destinationState.Vulkan;
+    vulkan.instance = vkInstance;
     auto vkSurface = dependencies.CreateVkSurfaceCallback(vkInstance);
     if (vkSurface == VK_NULL_HANDLE) {
+      dei::render::DestroyVulkanContext(vulkan);
       return false;
     }
-    destinationState.VulkanInstance = vkInstance;
-    destinationState.WindowSurface = vkSurface;
+    vulkan.windowSurface = vkSurface;
 
-    std::cout << "Created VkInstance: " << vkInstance
-              << " VkSurfaceKHR: " << vkSurface << std::endl;
+    DEI_LOG_INFO("Created VkInstance: %p VkSurfaceKHR: %p\n",
+        static_cast<void*>(vkInstance), static_cast<void*>(vkSurface));
 
     VkPhysicalDeviceFeatures requiredDeviceFeatures = {};
     requiredDeviceFeatures.imageCubeArray                             = true;
@@ -58,49 +160,176 @@ b8 EngineColdStartup(EngineState& destinationState, const EngineDependencies& de
     VkPhysicalDeviceLimits requiredDeviceLimits = {};
     requiredDeviceLimits.maxImageDimension2D = 1024;
     requiredDeviceLimits.maxVertexInputAttributes = 4;
-    auto maybeDevices = dei::render::PhysicalDevice::QueryAll(
-        destinationState.VulkanInstance);
+    auto maybeDevices = dei::render::PhysicalDevice::QueryAll(vulkan.instance);
     assert(maybeDevices);
     auto& physicalDevices = *maybeDevices;
+    // TODO: add multi device rendering
+    // the first device which can run the engine, discrete GPUs first
+    auto isDiscrete = [](const dei::render::PhysicalDevice* device) {
+        return device->GetProperties().deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU;
+    };
+    const dei::render::PhysicalDevice* selectedPhysicalDevice = nullptr;
     for (const auto& device : physicalDevices) {
         dei::render::PrintPhysicalDevice(device);
-        printf(" - Supports features : %d\n",
-            device.HasFeatures(requiredDeviceFeatures));
-        printf(" - Supports limits : %d\n",
-            device.HasLimits(requiredDeviceLimits));
+        auto hasFeatures = device.HasFeatures(requiredDeviceFeatures);
+        auto hasLimits = device.HasLimits(requiredDeviceLimits);
+        auto hasExtensions = dei::render::HasRequiredDeviceExtensions(device.GetDevice())
+            && dei::render::HasTimelineSemaphores(device.GetDevice());
+        auto hasQueues = dei::render::FindQueueFamilies(device.GetDevice(), vulkan.windowSurface).has_value();
+        DEI_LOG_INFO(" - Supports features : %d\n", hasFeatures);
+        DEI_LOG_INFO(" - Supports limits : %d\n", hasLimits);
+        DEI_LOG_INFO(" - Supports extensions : %d\n", hasExtensions);
+        DEI_LOG_INFO(" - Can present : %d\n", hasQueues);
+        if (hasFeatures && hasLimits && hasExtensions && hasQueues
+            && (selectedPhysicalDevice == nullptr || (!isDiscrete(selectedPhysicalDevice) && isDiscrete(&device)))) {
+            selectedPhysicalDevice = &device;
+        }
+    }
+    if (selectedPhysicalDevice == nullptr) {
+        DEI_LOG_ERROR("No physical device supports the required features, limits and presentation\n");
+        dei::render::DestroyVulkanContext(vulkan);
+        return false;
+    }
+    DEI_LOG_INFO("Selected physical device: %s (%s) !!!\n",
+        selectedPhysicalDevice->GetProperties().deviceName, selectedPhysicalDevice->GetDeviceTypeName());
+    vulkan.physicalDevice = selectedPhysicalDevice->GetDevice();
+    if (dei::render::CreateVulkanDevice(vulkan, requiredDeviceFeatures) == false
+        || dei::render::CreateFrameResources(vulkan, dependencies.NumFramesInFlight) == false
+        || dei::render::CreateUploadQueue(vulkan, dei::render::UPLOAD_STAGING_DEFAULT_BYTES) == false) {
+        dei::render::DestroyVulkanContext(vulkan);
+        return false;
     }
 
-    // TODO: add multi device rendering
-    auto selectedPhysicalDevice = std::move(*physicalDevices.begin());
-    std::cout << "Selected physical device: "
-        << selectedPhysicalDevice.GetProperties().deviceName << " ("
-        << selectedPhysicalDevice.GetDeviceTypeName() << ") !!!\n";
-    destinationState.PhysicalDevice = std::move(selectedPhysicalDevice).GetDevice();
+    destinationState.Timestep = dei::MakeFixedTimestep(dependencies.SimulationRateHz);
+    destinationState.CurrentSimulation = dei::SimulationState{};
+    destinationState.CurrentSimulation.CameraDistance = ::CAMERA_INITIAL_DISTANCE;
+    destinationState.PreviousSimulation = destinationState.CurrentSimulation;
     return true;
 }
 
 b8 EngineHotStartup(EngineState& engineState) {
+    DEI_PROFILE_SCOPE("EngineHotStartup");
     ::RunSandboxLogic();
-    (void)engineState;
+    engineState.NumTicksSinceHotStartup = 0;
+    // its thread runs this library's code, so it lives from load to unload
+    dei::render::StartPresentWaiter(engineState.Vulkan);
     return true;
 }
 
-b8 EngineTick(EngineState& engineState) {
+b8 EngineTick(EngineState& engineState, const EngineDependencies& dependencies) {
+   DEI_PROFILE_SCOPE("EngineTick");
+   auto allocationTag = platform::AllocationTagScope{platform::AllocationTag::ENGINE};
+   auto allocationGuard = platform::AllocationGuardScope{
+      engineState.NumTicksSinceHotStartup++ >= ::ALLOCATION_GUARD_WARMUP_TICKS};
+   if (dependencies.InputEvents != nullptr) {
+      ::DrainInputEvents(engineState, *dependencies.InputEvents);
+   }
+   if (dependencies.Input != nullptr) {
+      using dei::platform::input::KeyCode;
+      engineState.CameraZoomAxis =
+         static_cast<f32>(platform::input::InputIsDown(*dependencies.Input, KeyCode::KEY_W))
+         - static_cast<f32>(platform::input::InputIsDown(*dependencies.Input, KeyCode::KEY_S));
+   }
+   auto frameNanosec = dependencies.FrameNanosec != nullptr && *dependencies.FrameNanosec != 0
+      ? *dependencies.FrameNanosec
+      : platform::GetMonotonicNanosec();
+   auto numSteps = dei::FixedTimestepAdvance(engineState.Timestep, frameNanosec);
+   for (u32 step = 0; step < numSteps; ++step) {
+      if (EngineSimulate(engineState, engineState.Timestep.StepSec) == false) {
+         return false;
+      }
+   }
+   if (EngineRender(engineState, dependencies, dei::FixedTimestepAlpha(engineState.Timestep)) == false) {
+      return false;
+   }
+   if (dependencies.FrameStats != nullptr
+       && engineState.DrawCounter % ::FRAME_STATS_REPORT_EVERY == 0) {
+      ::ReportFrameStats(*dependencies.FrameStats);
+      ::ReportVulkanAllocations();
+      dei::render::PrintGpuMemoryStats(engineState.Vulkan.memory);
+      dei::render::PrintUploadQueueStats(engineState.Vulkan.uploads);
+   }
+   return true;
+}
+
+b8 EngineSimulate(EngineState& engineState, f64 fixedDeltaSec) {
+   DEI_PROFILE_SCOPE("EngineSimulate");
+   engineState.PreviousSimulation = engineState.CurrentSimulation;
+   auto& simulation = engineState.CurrentSimulation;
+   ++simulation.StepIndex;
+   simulation.TimeSec += fixedDeltaSec;
+   simulation.CameraDistance = std::clamp(
+      simulation.CameraDistance + engineState.PendingCameraZoom * ::CAMERA_ZOOM_PER_SCROLL
+         + engineState.CameraZoomAxis * ::CAMERA_ZOOM_PER_SEC * static_cast<f32>(fixedDeltaSec),
+      ::CAMERA_DISTANCE_MIN, ::CAMERA_DISTANCE_MAX);
+   engineState.PendingCameraZoom = 0.0f;
+   simulation.CameraRotation.x += ::CAMERA_ORBIT_RAD_PER_SEC * static_cast<f32>(fixedDeltaSec);
+   if (simulation.CameraRotation.x > glm::two_pi<f32>() || simulation.CameraRotation.x < 0.0f) {
+      // wrap both states, so interpolation doesn't spin through the whole circle
+      auto wrap = simulation.CameraRotation.x > 0.0f ? -glm::two_pi<f32>() : glm::two_pi<f32>();
+      simulation.CameraRotation.x += wrap;
+      engineState.PreviousSimulation.CameraRotation.x += wrap;
+   }
+   return true;
+}
+
+b8 EngineRender(EngineState& engineState, const EngineDependencies& dependencies, f64 alpha) {
+   DEI_PROFILE_SCOPE("EngineRender");
+   if (dependencies.MouseMotion != nullptr) {
+      // sampled as late as possible: mouse look goes straight into this frame's view,
+      // the zoom is simulated and lags by a step
+      auto motion = platform::input::MouseMotionTake(*dependencies.MouseMotion);
+      engineState.PendingCameraZoom += static_cast<f32>(motion.Scroll.y);
+      if (dependencies.Input != nullptr
+          && platform::input::InputIsDown(*dependencies.Input, platform::input::MouseButton::RIGHT)) {
+         auto look = vec2f(motion.Delta) * ::CAMERA_LOOK_RAD_PER_PIXEL;
+         for (auto* simulation : {&engineState.PreviousSimulation, &engineState.CurrentSimulation}) {
+            simulation->CameraRotation.x += look.x;
+            simulation->CameraRotation.y = std::clamp(simulation->CameraRotation.y + look.y,
+               -::CAMERA_PITCH_LIMIT_RAD, ::CAMERA_PITCH_LIMIT_RAD);
+         }
+      }
+   }
+   const auto& previous = engineState.PreviousSimulation;
+   const auto& current = engineState.CurrentSimulation;
+   auto t = static_cast<f32>(alpha);
+   auto cameraDistance = glm::mix(previous.CameraDistance, current.CameraDistance, t);
+   auto cameraRotation = glm::mix(previous.CameraRotation, current.CameraRotation, t);
+   engineState.ViewProjection = dei::MakeCamera(cameraDistance, cameraRotation);
+   if (dependencies.WindowSurface != nullptr) {
+      auto& vulkan = engineState.Vulkan;
+      // VK_NULL_HANDLE while minimized or while the swapchain can't be recreated
+      auto commandBuffer = render::BeginFrame(vulkan, *dependencies.WindowSurface, dependencies.Latency);
+      if (commandBuffer != VK_NULL_HANDLE) {
+         auto shade = 0.5f + 0.5f * std::sin(cameraRotation.x);
+         auto clearColor = VkClearColorValue{};
+         clearColor.float32[0] = 0.1f;
+         clearColor.float32[1] = 0.1f + 0.2f * shade;
+         clearColor.float32[2] = 0.3f - 0.2f * shade;
+         clearColor.float32[3] = 1.0f;
+         ::RecordClearPass(commandBuffer, vulkan.swapChainImages[vulkan.swapChainImageIndex], clearColor);
+         if (render::EndFrame(vulkan, dependencies.Latency) == false) {
+            return false;
+         }
+      } else if (render::UploadQueueSubmit(vulkan) == false) {
+         // the copies keep going while nothing is presented, acquired by the next frame rendered
+         return false;
+      }
+   }
    ++engineState.DrawCounter;
    return true;
 }
 
 b8 EngineReleaseResources(EngineState& engineState) {
-    (void)engineState;
+   dei::render::StopPresentWaiter(engineState.Vulkan);
    return true;
 }
 
 b8 EngineTerminate(EngineState& engineState) {
-   auto allocCallback = VkAllocationCallbacks{};
-   vkDestroySurfaceKHR(engineState.VulkanInstance, engineState.WindowSurface, &allocCallback);
-   engineState.WindowSurface = VK_NULL_HANDLE;
-   vkDestroyInstance(engineState.VulkanInstance, &allocCallback);
-   engineState.VulkanInstance = VK_NULL_HANDLE;
+   // what's still allocated here is leaked by its owner
+   dei::render::PrintGpuMemoryStats(engineState.Vulkan.memory);
+   dei::render::PrintUploadQueueStats(engineState.Vulkan.uploads);
+   dei::render::DestroyVulkanContext(engineState.Vulkan);
    return true;
 }
 
@@ -0,0 +1,390 @@
+#include "dei/GpuMemory.hpp"
+#include "dei_platform/Log.hpp"
+#include "dei_platform/VulkanAllocator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+namespace {
+
+using dei::render::GpuBuddyBlock;
+using dei::render::GpuMemory;
+using dei::render::GPU_MEMORY_BLOCK_BYTES;
+using dei::render::GPU_MEMORY_MIN_NODE_SHIFT;
+using dei::render::GPU_MEMORY_NUM_ORDERS;
+
+constexpr u32 MAX_ORDER = GPU_MEMORY_NUM_ORDERS - 1;
+constexpr f64 BYTES_PER_MIB = 1024.0 * 1024.0;
+
+struct DeviceMemory {
+   VkDeviceMemory memory;
+   u8* mapped;
+};
+
+inline auto AlignUp(VkDeviceSize value, VkDeviceSize alignment) -> VkDeviceSize {
+   return (value + alignment - 1) / alignment * alignment;
+}
+
+// the smallest order whose nodes hold numBytes
+inline auto OrderOf(VkDeviceSize numBytes) -> u32 {
+   u32 order = 0;
+   while ((VkDeviceSize{1} << (GPU_MEMORY_MIN_NODE_SHIFT + order)) < numBytes) {
+      ++order;
+   }
+   return order;
+}
+
+inline auto NodeBytes(u32 order) -> VkDeviceSize {
+   return VkDeviceSize{1} << (GPU_MEMORY_MIN_NODE_SHIFT + order);
+}
+
+inline auto IsFree(const GpuBuddyBlock& block, u32 order, u32 node) -> b8 {
+   return (block.freeBits[order][node / 64] >> (node % 64)) & 1;
+}
+
+inline auto SetFree(GpuBuddyBlock& block, u32 order, u32 node, b8 isFree) -> void {
+   auto bit = u64{1} << (node % 64);
+   auto& word = block.freeBits[order][node / 64];
+   word = isFree ? (word | bit) : (word & ~bit);
+}
+
+inline auto PushFree(GpuBuddyBlock& block, u32 order, u32 node) -> void {
+   ::SetFree(block, order, node, true);
+   block.freeNodes[order].push_back(node);
+}
+
+// a free node of the order, skips the entries of nodes merged into their parents meanwhile
+auto PopFree(GpuBuddyBlock& block, u32 order) -> std::optional<u32> {
+   auto& freeNodes = block.freeNodes[order];
+   while (!freeNodes.empty()) {
+      auto node = freeNodes.back();
+      freeNodes.pop_back();
+      if (::IsFree(block, order, node)) {
+         ::SetFree(block, order, node, false);
+         return node;
+      }
+   }
+   return std::nullopt;
+}
+
+auto InitBuddyBlock(GpuBuddyBlock& block) -> void {
+   for (u32 order = 0; order <= MAX_ORDER; ++order) {
+      auto numNodes = u32{1} << (MAX_ORDER - order);
+      block.freeBits[order].assign((numNodes + 63) / 64, 0);
+   }
+   ::PushFree(block, MAX_ORDER, 0);
+}
+
+// returns the offset, splits a larger node if there's no free node of the order
+auto BuddyAllocate(GpuBuddyBlock& block, u32 order) -> std::optional<VkDeviceSize> {
+   for (auto freeOrder = order; freeOrder <= MAX_ORDER; ++freeOrder) {
+      auto maybeNode = ::PopFree(block, freeOrder);
+      if (maybeNode == std::nullopt) {
+         continue;
+      }
+      auto node = *maybeNode;
+      while (freeOrder > order) {
+         --freeOrder;
+         node *= 2;
+         ::PushFree(block, freeOrder, node + 1);
+      }
+      block.usedBytes += ::NodeBytes(order);
+      ++block.numAllocations;
+      return static_cast<VkDeviceSize>(node) << (GPU_MEMORY_MIN_NODE_SHIFT + order);
+   }
+   return std::nullopt;
+}
+
+auto BuddyFree(GpuBuddyBlock& block, VkDeviceSize offset, u32 order) -> void {
+   block.usedBytes -= ::NodeBytes(order);
+   --block.numAllocations;
+   auto node = static_cast<u32>(offset >> (GPU_MEMORY_MIN_NODE_SHIFT + order));
+   while (order < MAX_ORDER && ::IsFree(block, order, node ^ 1)) {
+      // the buddy's free list entry goes stale
+      ::SetFree(block, order, node ^ 1, false);
+      node /= 2;
+      ++order;
+   }
+   ::PushFree(block, order, node);
+}
+
+auto LargestFreeBytes(const GpuBuddyBlock& block) -> VkDeviceSize {
+   for (auto order = static_cast<i32>(MAX_ORDER); order >= 0; --order) {
+      const auto& bits = block.freeBits[order];
+      if (std::any_of(bits.begin(), bits.end(), [](u64 word) { return word != 0; })) {
+         return ::NodeBytes(static_cast<u32>(order));
+      }
+   }
+   return 0;
+}
+
+auto AllocateDeviceMemory(GpuMemory& memory, u32 memoryType, VkDeviceSize numBytes) -> std::optional<DeviceMemory> {
+   if (memory.numDeviceAllocations >= memory.maxDeviceAllocations) {
+      DEI_LOG_ERROR("GpuMemory: maxMemoryAllocationCount (%u) reached\n", memory.maxDeviceAllocations);
+      return std::nullopt;
+   }
+   auto info = VkMemoryAllocateInfo{};
+   info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+   info.pNext = nullptr;
+   info.allocationSize = numBytes;
+   info.memoryTypeIndex = memoryType;
+   auto result = DeviceMemory{ VK_NULL_HANDLE, nullptr };
+   auto status = vkAllocateMemory(memory.device, &info, dei::platform::GetVulkanAllocationCallbacks(), &result.memory);
+   if (status != VK_SUCCESS) {
+      DEI_LOG_ERROR("GpuMemory: vkAllocateMemory of %lu bytes (type %u) failed (%d)\n", numBytes, memoryType, status);
+      return std::nullopt;
+   }
+   if (memory.properties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+      // mapped for the lifetime of the memory
+      void* mapped = nullptr;
+      if (vkMapMemory(memory.device, result.memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+         DEI_LOG_ERROR("GpuMemory: vkMapMemory (type %u) failed\n", memoryType);
+         vkFreeMemory(memory.device, result.memory, dei::platform::GetVulkanAllocationCallbacks());
+         return std::nullopt;
+      }
+      result.mapped = static_cast<u8*>(mapped);
+   }
+   ++memory.numDeviceAllocations;
+   memory.reservedBytes[memoryType] += numBytes;
+   return result;
+}
+
+auto FreeDeviceMemory(GpuMemory& memory, VkDeviceMemory deviceMemory, u32 memoryType, VkDeviceSize numBytes) -> void {
+   // unmaps it too
+   vkFreeMemory(memory.device, deviceMemory, dei::platform::GetVulkanAllocationCallbacks());
+   --memory.numDeviceAllocations;
+   memory.reservedBytes[memoryType] -= numBytes;
+}
+
+auto FindOrAddPool(GpuMemory& memory, u32 memoryType, dei::render::GpuResourceKind kind) -> u32 {
+   for (u32 i = 0; i < memory.pools.size(); ++i) {
+      if (memory.pools[i].memoryType == memoryType && memory.pools[i].kind == kind) {
+         return i;
+      }
+   }
+   memory.pools.push_back(dei::render::GpuMemoryPool{ memoryType, kind, {} });
+   return static_cast<u32>(memory.pools.size() - 1);
+}
+
+} // namespace ::
+
+namespace dei::render {
+
+auto CreateGpuMemory(VkPhysicalDevice physicalDevice, VkDevice device) -> GpuMemory {
+   auto memory = GpuMemory{};
+   memory.device = device;
+   vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memory.properties);
+   auto properties = VkPhysicalDeviceProperties{};
+   vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+   memory.nonCoherentAtomSize = std::max(properties.limits.nonCoherentAtomSize, VkDeviceSize{1});
+   memory.maxDeviceAllocations = properties.limits.maxMemoryAllocationCount;
+   return memory;
+}
+
+auto DestroyGpuMemory(GpuMemory& memory) -> void {
+   for (auto& pool : memory.pools) {
+      for (auto& block : pool.blocks) {
+         ::FreeDeviceMemory(memory, block.memory, pool.memoryType, GPU_MEMORY_BLOCK_BYTES);
+      }
+   }
+   if (memory.numDeviceAllocations > 0) {
+      DEI_LOG_WARN("GpuMemory: %u dedicated allocations or ring pools weren't freed\n", memory.numDeviceAllocations);
+   }
+   memory = GpuMemory{};
+}
+
+auto GpuMemoryFindType(const GpuMemory& memory, u32 typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+   -> u32 {
+   for (auto wanted : {required | preferred, required}) {
+      for (u32 type = 0; type < memory.properties.memoryTypeCount; ++type) {
+         if ((typeBits & (1u << type)) && (memory.properties.memoryTypes[type].propertyFlags & wanted) == wanted) {
+            return type;
+         }
+      }
+   }
+   return NO_MEMORY_TYPE;
+}
+
+auto GpuMemoryAllocate(GpuMemory& memory, const VkMemoryRequirements& requirements, VkMemoryPropertyFlags required,
+   VkMemoryPropertyFlags preferred, GpuResourceKind kind) -> std::optional<GpuAllocation> {
+   auto memoryType = GpuMemoryFindType(memory, requirements.memoryTypeBits, required, preferred);
+   if (memoryType == NO_MEMORY_TYPE) {
+      DEI_LOG_ERROR("GpuMemory: no memory type in 0x%x has properties 0x%x\n", requirements.memoryTypeBits, required);
+      return std::nullopt;
+   }
+   // nodes are aligned to their size
+   auto numBytes = std::max(requirements.size, requirements.alignment);
+   if (numBytes > GPU_MEMORY_BLOCK_BYTES / 2) {
+      auto deviceMemory = ::AllocateDeviceMemory(memory, memoryType, requirements.size);
+      if (deviceMemory == std::nullopt) {
+         return std::nullopt;
+      }
+      ++memory.numDedicated[memoryType];
+      memory.dedicatedBytes[memoryType] += requirements.size;
+      return GpuAllocation{ deviceMemory->memory, 0, requirements.size, deviceMemory->mapped, memoryType, 0, 0, 0, true };
+   }
+
+   auto order = ::OrderOf(numBytes);
+   auto poolIndex = ::FindOrAddPool(memory, memoryType, kind);
+   auto& pool = memory.pools[poolIndex];
+   for (u32 blockIndex = 0; blockIndex < pool.blocks.size(); ++blockIndex) {
+      auto& block = pool.blocks[blockIndex];
+      if (auto offset = ::BuddyAllocate(block, order)) {
+         return GpuAllocation{ block.memory, *offset, requirements.size,
+            block.mapped != nullptr ? block.mapped + *offset : nullptr,
+            memoryType, poolIndex, blockIndex, static_cast<u8>(order), false };
+      }
+   }
+   auto deviceMemory = ::AllocateDeviceMemory(memory, memoryType, GPU_MEMORY_BLOCK_BYTES);
+   if (deviceMemory == std::nullopt) {
+      return std::nullopt;
+   }
+   auto& block = pool.blocks.emplace_back();
+   block.memory = deviceMemory->memory;
+   block.mapped = deviceMemory->mapped;
+   ::InitBuddyBlock(block);
+   auto offset = *::BuddyAllocate(block, order);
+   return GpuAllocation{ block.memory, offset, requirements.size,
+      block.mapped != nullptr ? block.mapped + offset : nullptr,
+      memoryType, poolIndex, static_cast<u32>(pool.blocks.size() - 1), static_cast<u8>(order), false };
+}
+
+auto GpuMemoryFree(GpuMemory& memory, const GpuAllocation& allocation) -> void {
+   if (allocation.memory == VK_NULL_HANDLE) {
+      return;
+   }
+   if (allocation.isDedicated) {
+      --memory.numDedicated[allocation.memoryType];
+      memory.dedicatedBytes[allocation.memoryType] -= allocation.size;
+      ::FreeDeviceMemory(memory, allocation.memory, allocation.memoryType, allocation.size);
+      return;
+   }
+   // blocks are kept when they become empty, the next allocations reuse them
+   auto& block = memory.pools[allocation.poolIndex].blocks[allocation.blockIndex];
+   ::BuddyFree(block, allocation.offset, allocation.order);
+}
+
+auto GpuMemoryQueryStats(const GpuMemory& memory, u32 memoryType) -> GpuMemoryStats {
+   auto stats = GpuMemoryStats{};
+   VkDeviceSize freeBytes = 0;
+   VkDeviceSize largestFreeBytesSum = 0;
+   for (const auto& pool : memory.pools) {
+      if (memoryType != NO_MEMORY_TYPE && pool.memoryType != memoryType) {
+         continue;
+      }
+      for (const auto& block : pool.blocks) {
+         ++stats.numBlocks;
+         stats.numAllocations += block.numAllocations;
+         stats.usedBytes += block.usedBytes;
+         freeBytes += GPU_MEMORY_BLOCK_BYTES - block.usedBytes;
+         auto largestFreeBytes = ::LargestFreeBytes(block);
+         stats.largestFreeBytes = std::max(stats.largestFreeBytes, largestFreeBytes);
+         largestFreeBytesSum += largestFreeBytes;
+      }
+   }
+   for (u32 type = 0; type < memory.properties.memoryTypeCount; ++type) {
+      if (memoryType != NO_MEMORY_TYPE && type != memoryType) {
+         continue;
+      }
+      // ring pools count as reserved, their use changes every frame
+      stats.reservedBytes += memory.reservedBytes[type];
+      stats.numDedicated += memory.numDedicated[type];
+      stats.numAllocations += memory.numDedicated[type];
+      stats.usedBytes += memory.dedicatedBytes[type];
+   }
+   // free memory outside of the largest range of its block, empty blocks count as unfragmented
+   stats.fragmentation = freeBytes > 0
+      ? 1.0f - static_cast<f32>(static_cast<f64>(largestFreeBytesSum) / static_cast<f64>(freeBytes))
+      : 0.0f;
+   return stats;
+}
+
+auto PrintGpuMemoryStats(const GpuMemory& memory) -> void {
+   for (u32 type = 0; type < memory.properties.memoryTypeCount; ++type) {
+      if (memory.reservedBytes[type] == 0) {
+         continue;
+      }
+      auto stats = GpuMemoryQueryStats(memory, type);
+      DEI_LOG_INFO("GPU memory type %u (flags 0x%x): %u blocks, %u allocations (%u dedicated), "
+         "used %.1f of %.1f MiB, largest free %.1f MiB, fragmentation %.2f\n",
+         type, memory.properties.memoryTypes[type].propertyFlags, stats.numBlocks, stats.numAllocations, stats.numDedicated,
+         static_cast<f64>(stats.usedBytes) / ::BYTES_PER_MIB, static_cast<f64>(stats.reservedBytes) / ::BYTES_PER_MIB,
+         static_cast<f64>(stats.largestFreeBytes) / ::BYTES_PER_MIB, static_cast<f64>(stats.fragmentation));
+   }
+   DEI_LOG_INFO("GPU memory: %u of %u device allocations\n", memory.numDeviceAllocations, memory.maxDeviceAllocations);
+}
+
+auto CreateGpuRingPool(GpuMemory& memory, VkDeviceSize size, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+   -> std::optional<GpuRingPool> {
+   auto memoryType = GpuMemoryFindType(memory, ~0u, required | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, preferred);
+   if (memoryType == NO_MEMORY_TYPE) {
+      DEI_LOG_ERROR("GpuMemory: no host visible memory type has properties 0x%x\n", required);
+      return std::nullopt;
+   }
+   // flushed ranges are multiples of the atom, or reach the end of the memory
+   size = ::AlignUp(size, memory.nonCoherentAtomSize);
+   auto deviceMemory = ::AllocateDeviceMemory(memory, memoryType, size);
+   if (deviceMemory == std::nullopt) {
+      return std::nullopt;
+   }
+   auto ring = GpuRingPool{};
+   ring.memory = deviceMemory->memory;
+   ring.mapped = deviceMemory->mapped;
+   ring.size = size;
+   ring.atomSize = memory.nonCoherentAtomSize;
+   ring.memoryType = memoryType;
+   ring.isCoherent = (memory.properties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+   return ring;
+}
+
+auto DestroyGpuRingPool(GpuMemory& memory, GpuRingPool& ring) -> void {
+   if (ring.memory != VK_NULL_HANDLE) {
+      ::FreeDeviceMemory(memory, ring.memory, ring.memoryType, ring.size);
+   }
+   ring = GpuRingPool{};
+}
+
+auto GpuRingPoolBeginFrame(GpuRingPool& ring, u32 frameIndex) -> void {
+   ring.frameEnds[ring.frameIndex] = ring.head;
+   ring.tail = std::max(ring.tail, ring.frameEnds[frameIndex]);
+   ring.frameIndex = frameIndex;
+}
+
+auto GpuRingPoolAllocate(GpuRingPool& ring, VkDeviceSize size, VkDeviceSize alignment) -> std::optional<GpuAllocation> {
+   alignment = std::max(alignment, VkDeviceSize{1});
+   if (!ring.isCoherent) {
+      // a common multiple, alignments aren't always powers of 2 (texel sizes of 3 or 12 bytes)
+      alignment = std::lcm(alignment, ring.atomSize);
+      size = ::AlignUp(size, ring.atomSize);
+   }
+   auto position = ring.head % ring.size;
+   auto offset = ::AlignUp(position, alignment);
+   auto start = ring.head + (offset - position);
+   if (offset + size > ring.size) {
+      // allocations are contiguous, the end of the ring is skipped
+      start = ring.head + (ring.size - position);
+      offset = 0;
+   }
+   if (start + size - ring.tail > ring.size) {
+      return std::nullopt;
+   }
+   ring.head = start + size;
+   assert(offset % alignment == 0 && (ring.isCoherent || offset % ring.atomSize == 0));
+   return GpuAllocation{ ring.memory, offset, size, ring.mapped + offset, ring.memoryType, 0, 0, 0, false };
+}
+
+auto GpuRingPoolFlush(VkDevice device, const GpuRingPool& ring, const GpuAllocation& allocation) -> void {
+   if (ring.isCoherent) {
+      return;
+   }
+   auto range = VkMappedMemoryRange{};
+   range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+   range.pNext = nullptr;
+   range.memory = ring.memory;
+   range.offset = allocation.offset;
+   range.size = allocation.size;
+   vkFlushMappedMemoryRanges(device, 1, &range);
+}
+
+} // namespace dei
@@ -1,29 +1,24 @@
 #include "dei/Prelude.hpp"
 #include "dei/Entry.hpp"
 #include "dei/Camera.hpp"
+#include "dei_platform/Log.hpp"
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Weverything"
 #include <cr.h>
 #pragma clang diagnostic pop
 
-#include <iostream>
 #include <functional>
 
 namespace {
 
-struct HotReloadState {
-    dei::EngineState EngineState;
-    dei::EngineDependencies EngineDependencies;
-};
-
-static HotReloadState* state{nullptr};
+static dei::EngineHotReloadState* state{nullptr};
 
 inline auto OnHotLoad(cr_plugin *ctx) -> int {
-    std::cout << "cr::OnHotLoad() v" << ctx->version << " e" << ctx->failure << '\n';
+    DEI_LOG_INFO("cr::OnHotLoad() v%u e%d\n", ctx->version, static_cast<int>(ctx->failure));
     int err = 0;
     if (state == nullptr) {
-        state = reinterpret_cast<HotReloadState*>(ctx->userdata);
+        state = reinterpret_cast<dei::EngineHotReloadState*>(ctx->userdata);
         err = err || (dei::EngineColdStartup(state->EngineState, state->EngineDependencies) == false);
         err = err || (dei::EngineHotStartup(state->EngineState) == false);
     } else {
@@ -34,17 +29,22 @@ inline auto OnHotLoad(cr_plugin *ctx) -> int {
 
 inline auto OnUpdate(cr_plugin *ctx) -> int {
     (void)ctx;
-    return dei::EngineTick(state->EngineState) == false;
+    return dei::EngineTick(state->EngineState, state->EngineDependencies) == false;
 }
 
 inline auto OnHotUnload(cr_plugin *ctx) -> int {
-    std::cout << "cr::OnHotUnload() v" << ctx->version << " e" << ctx->failure << '\n';
-    return dei::EngineReleaseResources(state->EngineState) == false;
+    DEI_LOG_INFO("cr::OnHotUnload() v%u e%d\n", ctx->version, static_cast<int>(ctx->failure));
+    auto err = dei::EngineReleaseResources(state->EngineState) == false;
+    // pending records point to format strings in this library
+    dei::platform::LogFlush();
+    return err;
 }
 
 inline auto OnHotTerminate(cr_plugin *ctx) -> int {
-    std::cout << "cr::OnHotTerminate() v" << ctx->version << '\n';
-    return dei::EngineTerminate(state->EngineState) == false;
+    DEI_LOG_INFO("cr::OnHotTerminate() v%u\n", ctx->version);
+    auto err = dei::EngineTerminate(state->EngineState) == false;
+    dei::platform::LogFlush();
+    return err;
 }
 
 } // namespace ::
@@ -0,0 +1,544 @@
+#include "dei/Swapchain.hpp"
+#include "dei_platform/Log.hpp"
+#include "dei_platform/Time.hpp"
+#include "dei_platform/VulkanAllocator.hpp"
+
+#include <algorithm>
+
+namespace {
+
+using dei::platform::PresentPolicy;
+using dei::render::PRESENT_WAIT_FRAMES;
+
+constexpr u32 MAX_PRESENT_MODES_PER_POLICY = 3;
+
+// in the order of preference, unused entries are FIFO too
+constexpr VkPresentModeKHR PRESENT_MODES_OF_POLICY[][MAX_PRESENT_MODES_PER_POLICY] = {
+   /* VSYNC */ { VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR },
+   /* ADAPTIVE_VSYNC */ { VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_KHR },
+   /* LOW_LATENCY */ { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_FIFO_KHR },
+   /* UNCAPPED */ { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR },
+};
+
+constexpr const char* GetVkPresentModeStr(VkPresentModeKHR mode) {
+   switch (mode) {
+      case VK_PRESENT_MODE_IMMEDIATE_KHR: return "IMMEDIATE";
+      case VK_PRESENT_MODE_MAILBOX_KHR: return "MAILBOX";
+      case VK_PRESENT_MODE_FIFO_KHR: return "FIFO";
+      case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "FIFO_RELAXED";
+      default: return "UNKNOWN";
+   }
+}
+
+auto ChooseSurfaceFormat(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) -> std::optional<VkSurfaceFormatKHR> {
+   auto numFormats = u32{0};
+   vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &numFormats, nullptr);
+   auto formats = std::vector<VkSurfaceFormatKHR>(numFormats);
+   vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &numFormats, formats.data());
+   if (formats.empty()) {
+      return std::nullopt;
+   }
+   for (const auto& format : formats) {
+      if ((format.format == VK_FORMAT_B8G8R8A8_SRGB || format.format == VK_FORMAT_R8G8B8A8_SRGB)
+          && format.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+         return format;
+      }
+   }
+   return formats[0];
+}
+
+// FIFO needs an image on screen and one to render into; a third one lets MAILBOX replace queued frames,
+// beyond that every frame in flight may hold an image while the GPU renders it
+auto ChooseImageCount(const VkSurfaceCapabilitiesKHR& capabilities, VkPresentModeKHR presentMode, u32 numFramesInFlight) -> u32 {
+   auto numImages = std::max({ capabilities.minImageCount, 2u,
+      numFramesInFlight + (presentMode == VK_PRESENT_MODE_MAILBOX_KHR ? 1u : 0u) });
+   if (capabilities.maxImageCount > 0) {
+      numImages = std::min(numImages, capabilities.maxImageCount);
+   }
+   return numImages;
+}
+
+auto DestroyImageSemaphores(dei::render::VulkanContext& context) -> void {
+   for (auto semaphore : context.renderingFinishedSemaphores) {
+      vkDestroySemaphore(context.device, semaphore, dei::platform::GetVulkanAllocationCallbacks());
+   }
+   context.renderingFinishedSemaphores.clear();
+}
+
+// a wait returns this often to see if its job was canceled
+constexpr u64 PRESENT_WAIT_TIMEOUT_NANOSEC = 50000000ULL;
+
+auto PresentWaiterLoop(dei::render::PresentWaiter* waiter) -> void {
+   auto lock = std::unique_lock<std::mutex>{waiter->mutex};
+   while (true) {
+      waiter->jobPushed.wait(lock, [waiter]() {
+         return !waiter->isRunning || waiter->numJobsDone < waiter->numJobsPushed;
+      });
+      if (!waiter->isRunning) {
+         return;
+      }
+      auto job = waiter->jobs[waiter->numJobsDone % PRESENT_WAIT_FRAMES];
+      lock.unlock();
+      auto result = VK_TIMEOUT;
+      while (result == VK_TIMEOUT && !waiter->isCanceled.load(std::memory_order_acquire)) {
+         result = job.swapChain != VK_NULL_HANDLE
+            ? waiter->waitForPresent(waiter->device, job.swapChain, job.presentId, ::PRESENT_WAIT_TIMEOUT_NANOSEC)
+            : vkWaitForFences(waiter->device, 1, &job.fence, VK_TRUE, ::PRESENT_WAIT_TIMEOUT_NANOSEC);
+      }
+      // taken as the wait returns, it's late only by the thread's wake up
+      auto presentNanosec = dei::platform::GetMonotonicNanosec();
+      lock.lock();
+      // canceled, out of date or lost surface: not reported
+      if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR) {
+         if (waiter->numResultsPushed - waiter->numResultsTaken >= PRESENT_WAIT_FRAMES) {
+            // the oldest result is overwritten, it's never reported
+            ++waiter->numResultsTaken;
+         }
+         waiter->results[waiter->numResultsPushed++ % PRESENT_WAIT_FRAMES] =
+            dei::render::PresentWaitResult{ job.latencyFrameId, presentNanosec };
+      }
+      ++waiter->numJobsDone;
+      waiter->jobDone.notify_all();
+   }
+}
+
+// returns the job's index, NO_PRESENT_WAIT_JOB if the waiter is PRESENT_WAIT_FRAMES jobs behind (the frame isn't measured)
+auto PushPresentWaitJob(dei::render::PresentWaiter& waiter, const dei::render::PresentWaitJob& job) -> u64 {
+   auto index = dei::render::NO_PRESENT_WAIT_JOB;
+   {
+      std::lock_guard<std::mutex> lock{waiter.mutex};
+      if (waiter.numJobsPushed - waiter.numJobsDone >= PRESENT_WAIT_FRAMES) {
+         return index;
+      }
+      index = waiter.numJobsPushed++;
+      waiter.jobs[index % PRESENT_WAIT_FRAMES] = job;
+   }
+   waiter.jobPushed.notify_one();
+   return index;
+}
+
+// returns once the waiter is done with the job, before its fence is reset
+auto FinishPresentWaitJob(dei::render::PresentWaiter* waiter, u64 job) -> void {
+   if (waiter == nullptr || job == dei::render::NO_PRESENT_WAIT_JOB) {
+      return;
+   }
+   auto lock = std::unique_lock<std::mutex>{waiter->mutex};
+   waiter->jobDone.wait(lock, [waiter, job]() { return waiter->numJobsDone > job; });
+}
+
+// drops the pending jobs, returns once the waiter no longer uses their swapchain and fences
+auto CancelPresentWaits(dei::render::VulkanContext& context) -> void {
+   auto* waiter = context.presentWaiter;
+   if (waiter == nullptr) {
+      return;
+   }
+   waiter->isCanceled.store(true, std::memory_order_release);
+   {
+      auto lock = std::unique_lock<std::mutex>{waiter->mutex};
+      waiter->jobDone.wait(lock, [waiter]() { return waiter->numJobsDone == waiter->numJobsPushed; });
+   }
+   waiter->isCanceled.store(false, std::memory_order_release);
+}
+
+// reports the frames the waiter saw presented (or finished by the GPU) since the previous call, never blocks
+auto ReportPresentedFrames(dei::render::VulkanContext& context, dei::platform::LatencyProbe* latency) -> void {
+   auto* waiter = context.presentWaiter;
+   if (latency == nullptr || waiter == nullptr) {
+      return;
+   }
+   dei::render::PresentWaitResult results[PRESENT_WAIT_FRAMES];
+   u32 numResults = 0;
+   {
+      std::lock_guard<std::mutex> lock{waiter->mutex};
+      while (waiter->numResultsTaken < waiter->numResultsPushed) {
+         results[numResults++] = waiter->results[waiter->numResultsTaken++ % PRESENT_WAIT_FRAMES];
+      }
+   }
+   for (u32 i = 0; i < numResults; ++i) {
+      dei::platform::LatencyProbePresentFrame(*latency, results[i].latencyFrameId, results[i].presentNanosec);
+   }
+}
+
+// recreates the swapchain if it's unusable, the present policy changed, or the window was resized
+// and kept its size for a while, false if there's nothing to present to
+auto UpdateSwapchain(dei::render::VulkanContext& context, const dei::platform::WindowSurfaceState& surface) -> b8 {
+   // the size is stored before the counter is released
+   auto numResizes = surface.NumResizes.load(std::memory_order_acquire);
+   auto sizePx = dei::platform::WindowSurfaceGetSize(surface);
+   auto policy = surface.Present.load(std::memory_order_relaxed);
+   if (sizePx.x <= 0 || sizePx.y <= 0) {
+      return false;
+   }
+   auto isResized = (numResizes != context.appliedNumResizes || context.isSwapChainSuboptimal)
+      && dei::platform::GetMonotonicNanosec() - surface.LastResizeNanosec.load(std::memory_order_relaxed)
+         >= dei::render::SWAPCHAIN_RESIZE_DEBOUNCE_NANOSEC;
+   if (context.swapChain != VK_NULL_HANDLE && !context.isSwapChainOutOfDate
+       && !isResized && policy == context.presentPolicy) {
+      return true;
+   }
+   auto sizeExtent = VkExtent2D{ static_cast<u32>(sizePx.x), static_cast<u32>(sizePx.y) };
+   if (dei::render::CreateSwapchain(context, sizeExtent, policy) == false) {
+      return false;
+   }
+   context.appliedNumResizes = numResizes;
+   return true;
+}
+
+} // namespace ::
+
+namespace dei::render {
+
+auto ChoosePresentMode(const VkPresentModeKHR* supportedModes, u32 numSupportedModes, platform::PresentPolicy policy)
+   -> VkPresentModeKHR {
+   for (auto mode : ::PRESENT_MODES_OF_POLICY[static_cast<u32>(policy)]) {
+      if (std::find(supportedModes, supportedModes + numSupportedModes, mode) != supportedModes + numSupportedModes) {
+         return mode;
+      }
+   }
+   return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+auto CreateFrameResources(VulkanContext& context, u32 numFramesInFlight) -> b8 {
+   auto* allocator = platform::GetVulkanAllocationCallbacks();
+   context.numFramesInFlight = std::clamp(numFramesInFlight, 1u, MAX_FRAMES_IN_FLIGHT);
+   context.frameIndex = 0;
+
+   auto poolInfo = VkCommandPoolCreateInfo{};
+   poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+   poolInfo.pNext = nullptr;
+   // every frame re-records its command buffer
+   poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+   poolInfo.queueFamilyIndex = context.queueFamilies.graphics;
+   auto result = vkCreateCommandPool(context.device, &poolInfo, allocator, &context.commandPool);
+   if (result != VK_SUCCESS) {
+      DEI_LOG_ERROR("Vulkan: vkCreateCommandPool failed (%d)\n", result);
+      return false;
+   }
+   context.presentCommandBuffers.resize(context.numFramesInFlight);
+   auto allocateInfo = VkCommandBufferAllocateInfo{};
+   allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+   allocateInfo.pNext = nullptr;
+   allocateInfo.commandPool = context.commandPool;
+   allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+   allocateInfo.commandBufferCount = context.numFramesInFlight;
+   result = vkAllocateCommandBuffers(context.device, &allocateInfo, context.presentCommandBuffers.data());
+   if (result != VK_SUCCESS) {
+      DEI_LOG_ERROR("Vulkan: vkAllocateCommandBuffers failed (%d)\n", result);
+      return false;
+   }
+
+   auto semaphoreInfo = VkSemaphoreCreateInfo{};
+   semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+   semaphoreInfo.pNext = nullptr;
+   semaphoreInfo.flags = 0;
+   auto fenceInfo = VkFenceCreateInfo{};
+   fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+   fenceInfo.pNext = nullptr;
+   // the first wait for each frame returns right away
+   fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+   for (u32 i = 0; i < context.numFramesInFlight; ++i) {
+      auto& frame = context.framesInFlight[i];
+      frame.presentWaitJob = NO_PRESENT_WAIT_JOB;
+      if (vkCreateSemaphore(context.device, &semaphoreInfo, allocator, &frame.imageAvailableSemaphore) != VK_SUCCESS
+          || vkCreateFence(context.device, &fenceInfo, allocator, &frame.inFlightFence) != VK_SUCCESS) {
+         DEI_LOG_ERROR("Vulkan: can't create the synchronization of frame in flight %u\n", i);
+         return false;
+      }
+   }
+   DEI_LOG_INFO("Vulkan: %u frames in flight\n", context.numFramesInFlight);
+   return true;
+}
+
+auto CreateSwapchain(VulkanContext& context, VkExtent2D framebufferSizePx, platform::PresentPolicy policy) -> b8 {
+   auto* allocator = platform::GetVulkanAllocationCallbacks();
+   auto capabilities = VkSurfaceCapabilitiesKHR{};
+   auto result = vkGetPhysicalDeviceSurfaceCapabilitiesKHR(context.physicalDevice, context.windowSurface, &capabilities);
+   if (result != VK_SUCCESS) {
+      DEI_LOG_ERROR("Vulkan: can't query the surface capabilities (%d)\n", result);
+      return false;
+   }
+   // the surface either dictates the extent or takes it from the swapchain
+   auto extent = capabilities.currentExtent;
+   if (extent.width == UINT32_MAX) {
+      extent.width = std::clamp(framebufferSizePx.width, capabilities.minImageExtent.width, capabilities.maxImageExtent.width);
+      extent.height = std::clamp(framebufferSizePx.height, capabilities.minImageExtent.height, capabilities.maxImageExtent.height);
+   }
+   if (extent.width == 0 || extent.height == 0) {
+      return false;
+   }
+   if ((capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) == 0) {
+      DEI_LOG_ERROR("Vulkan: the surface images can't be transfer destinations\n");
+      return false;
+   }
+   auto maybeFormat = ::ChooseSurfaceFormat(context.physicalDevice, context.windowSurface);
+   if (maybeFormat == std::nullopt) {
+      DEI_LOG_ERROR("Vulkan: the surface has no formats\n");
+      return false;
+   }
+   auto numPresentModes = u32{0};
+   vkGetPhysicalDeviceSurfacePresentModesKHR(context.physicalDevice, context.windowSurface, &numPresentModes, nullptr);
+   VkPresentModeKHR presentModes[8];
+   numPresentModes = std::min(numPresentModes, static_cast<u32>(std::size(presentModes)));
+   vkGetPhysicalDeviceSurfacePresentModesKHR(context.physicalDevice, context.windowSurface, &numPresentModes, presentModes);
+   auto presentMode = ChoosePresentMode(presentModes, numPresentModes, policy);
+
+   const u32 queueFamilies[] = { context.queueFamilies.graphics, context.queueFamilies.present };
+   auto isSharedByQueues = queueFamilies[0] != queueFamilies[1];
+   auto info = VkSwapchainCreateInfoKHR{};
+   info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+   info.pNext = nullptr;
+   info.flags = 0;
+   info.surface = context.windowSurface;
+   info.minImageCount = ::ChooseImageCount(capabilities, presentMode, context.numFramesInFlight);
+   info.imageFormat = maybeFormat->format;
+   info.imageColorSpace = maybeFormat->colorSpace;
+   info.imageExtent = extent;
+   info.imageArrayLayers = 1;
+   info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+   info.imageSharingMode = isSharedByQueues ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+   info.queueFamilyIndexCount = isSharedByQueues ? 2 : 0;
+   info.pQueueFamilyIndices = isSharedByQueues ? queueFamilies : nullptr;
+   info.preTransform = capabilities.currentTransform;
+   info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+   info.presentMode = presentMode;
+   info.clipped = VK_TRUE;
+   // lets the presentation engine hand over the images still on screen
+   info.oldSwapchain = context.swapChain;
+
+   // the old images and semaphores may still be used by frames in flight, recreation is rare enough to wait
+   vkDeviceWaitIdle(context.device);
+   ::CancelPresentWaits(context);
+   auto swapChain = VkSwapchainKHR{};
+   result = vkCreateSwapchainKHR(context.device, &info, allocator, &swapChain);
+   if (context.swapChain != VK_NULL_HANDLE) {
+      vkDestroySwapchainKHR(context.device, context.swapChain, allocator);
+      context.swapChain = VK_NULL_HANDLE;
+   }
+   ::DestroyImageSemaphores(context);
+   if (result != VK_SUCCESS) {
+      DEI_LOG_ERROR("Vulkan: vkCreateSwapchainKHR failed (%d)\n", result);
+      return false;
+   }
+   context.swapChain = swapChain;
+   context.swapChainFormat = *maybeFormat;
+   context.swapChainExtent = extent;
+   context.presentMode = presentMode;
+   context.presentPolicy = policy;
+   context.isSwapChainOutOfDate = false;
+   context.isSwapChainSuboptimal = false;
+
+   auto numImages = u32{0};
+   vkGetSwapchainImagesKHR(context.device, swapChain, &numImages, nullptr);
+   context.swapChainImages.resize(numImages);
+   vkGetSwapchainImagesKHR(context.device, swapChain, &numImages, context.swapChainImages.data());
+   auto semaphoreInfo = VkSemaphoreCreateInfo{};
+   semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+   semaphoreInfo.pNext = nullptr;
+   semaphoreInfo.flags = 0;
+   context.renderingFinishedSemaphores.resize(numImages);
+   for (auto& semaphore : context.renderingFinishedSemaphores) {
+      if (vkCreateSemaphore(context.device, &semaphoreInfo, allocator, &semaphore) != VK_SUCCESS) {
+         DEI_LOG_ERROR("Vulkan: can't create the swapchain semaphores\n");
+         semaphore = VK_NULL_HANDLE;
+         return false;
+      }
+   }
+   DEI_LOG_INFO("Vulkan: swapchain %ux%u, %u images, %s (%s policy)\n",
+      extent.width, extent.height, numImages, ::GetVkPresentModeStr(presentMode), platform::PresentPolicyToStr(policy));
+   return true;
+}
+
+auto DestroySwapchain(VulkanContext& context) -> void {
+   auto* allocator = platform::GetVulkanAllocationCallbacks();
+   if (context.device == VK_NULL_HANDLE) {
+      return;
+   }
+   vkDeviceWaitIdle(context.device);
+   ::CancelPresentWaits(context);
+   ::DestroyImageSemaphores(context);
+   if (context.swapChain != VK_NULL_HANDLE) {
+      vkDestroySwapchainKHR(context.device, context.swapChain, allocator);
+      context.swapChain = VK_NULL_HANDLE;
+   }
+   context.swapChainImages.clear();
+   for (auto& frame : context.framesInFlight) {
+      if (frame.imageAvailableSemaphore != VK_NULL_HANDLE) {
+         vkDestroySemaphore(context.device, frame.imageAvailableSemaphore, allocator);
+      }
+      if (frame.inFlightFence != VK_NULL_HANDLE) {
+         vkDestroyFence(context.device, frame.inFlightFence, allocator);
+      }
+      frame = FrameInFlight{};
+   }
+   if (context.commandPool != VK_NULL_HANDLE) {
+      // frees the command buffers too
+      vkDestroyCommandPool(context.device, context.commandPool, allocator);
+      context.commandPool = VK_NULL_HANDLE;
+   }
+   context.presentCommandBuffers.clear();
+   context.numFramesInFlight = 0;
+}
+
+auto StartPresentWaiter(VulkanContext& context) -> void {
+   if (context.device == VK_NULL_HANDLE || context.presentWaiter != nullptr) {
+      return;
+   }
+   auto* waiter = new PresentWaiter{};
+   waiter->device = context.device;
+   waiter->waitForPresent = context.waitForPresent;
+   waiter->isRunning = true;
+   waiter->thread = std::thread{&::PresentWaiterLoop, waiter};
+   context.presentWaiter = waiter;
+}
+
+auto StopPresentWaiter(VulkanContext& context) -> void {
+   auto* waiter = context.presentWaiter;
+   if (waiter == nullptr) {
+      return;
+   }
+   waiter->isCanceled.store(true, std::memory_order_release);
+   {
+      std::lock_guard<std::mutex> lock{waiter->mutex};
+      waiter->isRunning = false;
+   }
+   waiter->jobPushed.notify_one();
+   waiter->thread.join();
+   delete waiter;
+   context.presentWaiter = nullptr;
+   // the jobs of the frames in flight are gone with the waiter
+   for (auto& frame : context.framesInFlight) {
+      frame.presentWaitJob = NO_PRESENT_WAIT_JOB;
+   }
+}
+
+auto BeginFrame(VulkanContext& context, const platform::WindowSurfaceState& surface, platform::LatencyProbe* latency)
+   -> VkCommandBuffer {
+   platform::VulkanAllocatorBeginFrame();
+   ::ReportPresentedFrames(context, latency);
+   if (::UpdateSwapchain(context, surface) == false) {
+      return VK_NULL_HANDLE;
+   }
+   auto& frame = context.framesInFlight[context.frameIndex];
+   // bounds how far the CPU runs ahead of the GPU
+   vkWaitForFences(context.device, 1, &frame.inFlightFence, VK_TRUE, UINT64_MAX);
+   ::ReportPresentedFrames(context, latency);
+   auto result = vkAcquireNextImageKHR(context.device, context.swapChain, UINT64_MAX,
+      frame.imageAvailableSemaphore, VK_NULL_HANDLE, &context.swapChainImageIndex);
+   if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+      context.isSwapChainOutOfDate = true;
+      return VK_NULL_HANDLE;
+   }
+   if (result == VK_SUBOPTIMAL_KHR) {
+      // still presentable, recreated once the size settles
+      context.isSwapChainSuboptimal = true;
+   } else if (result != VK_SUCCESS) {
+      DEI_LOG_ERROR("Vulkan: vkAcquireNextImageKHR failed (%d)\n", result);
+      return VK_NULL_HANDLE;
+   }
+   // the fence is signaled, the waiter returns from it right away
+   ::FinishPresentWaitJob(context.presentWaiter, frame.presentWaitJob);
+   frame.presentWaitJob = NO_PRESENT_WAIT_JOB;
+   // only once the frame will surely be submitted, or the next wait on the fence never returns
+   vkResetFences(context.device, 1, &frame.inFlightFence);
+
+   auto commandBuffer = context.presentCommandBuffers[context.frameIndex];
+   vkResetCommandBuffer(commandBuffer, 0);
+   auto beginInfo = VkCommandBufferBeginInfo{};
+   beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+   beginInfo.pNext = nullptr;
+   beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+   beginInfo.pInheritanceInfo = nullptr;
+   vkBeginCommandBuffer(commandBuffer, &beginInfo);
+   UploadRecordAcquires(context, commandBuffer);
+   return commandBuffer;
+}
+
+auto EndFrame(VulkanContext& context, platform::LatencyProbe* latency) -> b8 {
+   auto& frame = context.framesInFlight[context.frameIndex];
+   auto commandBuffer = context.presentCommandBuffers[context.frameIndex];
+   auto renderingFinishedSemaphore = context.renderingFinishedSemaphores[context.swapChainImageIndex];
+   vkEndCommandBuffer(commandBuffer);
+
+   // the image may be acquired before the presentation engine is done reading it
+   const VkPipelineStageFlags waitStages[] = {
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+      // the upload batches acquired by this frame, only waited for once, and only by the frame after their submission
+      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+   };
+   const VkSemaphore waitSemaphores[] = { frame.imageAvailableSemaphore, context.uploads.timeline };
+   // the binary semaphore's value is ignored
+   const u64 waitValues[] = { 0, context.uploads.frameWaitValue };
+   auto timelineInfo = VkTimelineSemaphoreSubmitInfo{};
+   timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+   timelineInfo.pNext = nullptr;
+   timelineInfo.waitSemaphoreValueCount = 2;
+   timelineInfo.pWaitSemaphoreValues = waitValues;
+   timelineInfo.signalSemaphoreValueCount = 0;
+   timelineInfo.pSignalSemaphoreValues = nullptr;
+   auto waitsForUploads = context.uploads.frameWaitValue > context.uploads.waitedValue;
+   auto submitInfo = VkSubmitInfo{};
+   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+   submitInfo.pNext = waitsForUploads ? &timelineInfo : nullptr;
+   submitInfo.waitSemaphoreCount = waitsForUploads ? 2 : 1;
+   submitInfo.pWaitSemaphores = waitSemaphores;
+   submitInfo.pWaitDstStageMask = waitStages;
+   submitInfo.commandBufferCount = 1;
+   submitInfo.pCommandBuffers = &commandBuffer;
+   submitInfo.signalSemaphoreCount = 1;
+   submitInfo.pSignalSemaphores = &renderingFinishedSemaphore;
+   auto result = vkQueueSubmit(context.graphicsQueue, 1, &submitInfo, frame.inFlightFence);
+   if (result != VK_SUCCESS) {
+      DEI_LOG_ERROR("Vulkan: vkQueueSubmit failed (%d)\n", result);
+      return false;
+   }
+   context.uploads.waitedValue = std::max(context.uploads.waitedValue, context.uploads.frameWaitValue);
+   // the copies recorded this frame run on the transfer queue while the GPU renders it
+   if (UploadQueueSubmit(context) == false) {
+      return false;
+   }
+   // reported once presented with present wait, otherwise once the GPU finished it
+   auto hasLatencyFrame = latency != nullptr && latency->NumFrames > 0 && context.presentWaiter != nullptr;
+   auto latencyFrameId = hasLatencyFrame ? platform::LatencyProbeCurrentFrame(*latency) : u64{0};
+   auto presentId = u64{0};
+   if (hasLatencyFrame && context.waitForPresent != nullptr) {
+      presentId = ++context.lastPresentId;
+   } else if (hasLatencyFrame) {
+      frame.presentWaitJob = ::PushPresentWaitJob(*context.presentWaiter,
+         PresentWaitJob{ VK_NULL_HANDLE, 0, frame.inFlightFence, latencyFrameId });
+   }
+   if (hasLatencyFrame) {
+      latency->IsReportedByRenderer = true;
+   }
+   auto presentIdInfo = VkPresentIdKHR{};
+   presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+   presentIdInfo.pNext = nullptr;
+   presentIdInfo.swapchainCount = 1;
+   presentIdInfo.pPresentIds = &presentId;
+
+   auto presentInfo = VkPresentInfoKHR{};
+   presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+   presentInfo.pNext = presentId != 0 ? &presentIdInfo : nullptr;
+   presentInfo.waitSemaphoreCount = 1;
+   presentInfo.pWaitSemaphores = &renderingFinishedSemaphore;
+   presentInfo.swapchainCount = 1;
+   presentInfo.pSwapchains = &context.swapChain;
+   presentInfo.pImageIndices = &context.swapChainImageIndex;
+   presentInfo.pResults = nullptr;
+   result = vkQueuePresentKHR(context.presentQueue, &presentInfo);
+   if (presentId != 0 && (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)) {
+      ::PushPresentWaitJob(*context.presentWaiter,
+         PresentWaitJob{ context.swapChain, presentId, VK_NULL_HANDLE, latencyFrameId });
+   }
+   context.frameIndex = (context.frameIndex + 1) % context.numFramesInFlight;
+   if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+      context.isSwapChainOutOfDate = true;
+   } else if (result == VK_SUBOPTIMAL_KHR) {
+      context.isSwapChainSuboptimal = true;
+   } else if (result != VK_SUCCESS) {
+      DEI_LOG_ERROR("Vulkan: vkQueuePresentKHR failed (%d)\n", result);
+      return result != VK_ERROR_DEVICE_LOST;
+   }
+   return true;
+}
+
+} // namespace dei
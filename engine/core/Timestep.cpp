@@ -0,0 +1,48 @@
+#include "dei/Timestep.hpp"
+
+#include <algorithm>
+
+namespace dei {
+
+auto MakeFixedTimestep(f64 simulationRateHz, u32 maxStepsPerFrame, f64 maxFrameSec) -> FixedTimestep {
+    auto timestep = FixedTimestep{};
+    timestep.StepSec = 1.0 / std::max(simulationRateHz, 1.0);
+    timestep.MaxStepsPerFrame = std::max(maxStepsPerFrame, 1u);
+    timestep.MaxFrameSec = std::max(maxFrameSec, timestep.StepSec);
+    return timestep;
+}
+
+auto FixedTimestepAdvance(FixedTimestep& timestep, i64 nowNanosec) -> u32 {
+    if (timestep.LastFrameNanosec == 0) {
+        timestep.LastFrameNanosec = nowNanosec;
+        return 0;
+    }
+    auto frameSec = static_cast<f64>(nowNanosec - timestep.LastFrameNanosec) * 1e-9;
+    timestep.LastFrameNanosec = nowNanosec;
+    if (frameSec > timestep.MaxFrameSec) {
+        timestep.DroppedSec += frameSec - timestep.MaxFrameSec;
+        frameSec = timestep.MaxFrameSec;
+    }
+    timestep.AccumulatorSec += frameSec;
+
+    u32 numSteps = 0;
+    while (timestep.AccumulatorSec >= timestep.StepSec && numSteps < timestep.MaxStepsPerFrame) {
+        timestep.AccumulatorSec -= timestep.StepSec;
+        ++numSteps;
+    }
+    if (timestep.AccumulatorSec >= timestep.StepSec) {
+        // can't keep up, let the simulation run slower than real time instead of falling behind forever
+        auto keptSec = timestep.AccumulatorSec - timestep.StepSec * static_cast<f64>(
+            static_cast<u64>(timestep.AccumulatorSec / timestep.StepSec));
+        timestep.DroppedSec += timestep.AccumulatorSec - keptSec;
+        timestep.AccumulatorSec = keptSec;
+    }
+    timestep.NumSteps += numSteps;
+    return numSteps;
+}
+
+auto FixedTimestepAlpha(const FixedTimestep& timestep) -> f64 {
+    return std::clamp(timestep.AccumulatorSec / timestep.StepSec, 0.0, 1.0);
+}
+
+}
@@ -0,0 +1,389 @@
+#include "dei/Upload.hpp"
+#include "dei/Vulkan.hpp"
+#include "dei_platform/Log.hpp"
+#include "dei_platform/VulkanAllocator.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+// the first copies of a frame rarely need more, the vectors only grow past it on loading spikes
+constexpr size_t UPLOAD_RESERVED_BARRIERS = 64;
+constexpr VkDeviceSize STAGING_SIZE_GRANULARITY = 64 * 1024;
+
+auto HasOwnershipTransfer(const dei::render::VulkanContext& context) -> b8 {
+   return context.queueFamilies.transfer != context.queueFamilies.graphics;
+}
+
+auto RefreshCompletedValue(dei::render::VulkanContext& context) -> u64 {
+   auto& uploads = context.uploads;
+   auto value = u64{0};
+   if (vkGetSemaphoreCounterValue(context.device, uploads.timeline, &value) == VK_SUCCESS) {
+      uploads.completedValue = std::max(uploads.completedValue, value);
+   }
+   return uploads.completedValue;
+}
+
+// starts recording into the next batch slot unless its previous batch is still executing
+auto EnsureRecording(dei::render::VulkanContext& context) -> b8 {
+   auto& uploads = context.uploads;
+   if (uploads.isRecording) {
+      return true;
+   }
+   auto& batch = uploads.batches[uploads.batchIndex];
+   if (batch.timelineValue > uploads.completedValue && batch.timelineValue > ::RefreshCompletedValue(context)) {
+      return false;
+   }
+   // what the slot's previous batch copied from is free now
+   dei::render::GpuRingPoolBeginFrame(uploads.staging, uploads.batchIndex);
+   vkResetCommandBuffer(batch.commandBuffer, 0);
+   auto beginInfo = VkCommandBufferBeginInfo{};
+   beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+   beginInfo.pNext = nullptr;
+   beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+   beginInfo.pInheritanceInfo = nullptr;
+   if (vkBeginCommandBuffer(batch.commandBuffer, &beginInfo) != VK_SUCCESS) {
+      return false;
+   }
+   uploads.isRecording = true;
+   uploads.numBatchCopies = 0;
+   return true;
+}
+
+auto AllocateStaging(dei::render::VulkanContext& context, VkDeviceSize size, VkDeviceSize alignment)
+   -> std::optional<dei::render::GpuAllocation> {
+   auto& uploads = context.uploads;
+   if (!::EnsureRecording(context)) {
+      ++uploads.numDeferred;
+      return std::nullopt;
+   }
+   auto allocation = dei::render::GpuRingPoolAllocate(uploads.staging, size, alignment);
+   if (allocation == std::nullopt) {
+      ++uploads.numDeferred;
+   }
+   return allocation;
+}
+
+auto MakeImageBarrier(VkImage image, const dei::render::UploadImageRegion& region) -> VkImageMemoryBarrier {
+   auto barrier = VkImageMemoryBarrier{};
+   barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+   barrier.pNext = nullptr;
+   barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+   barrier.image = image;
+   barrier.subresourceRange.aspectMask = region.aspect;
+   barrier.subresourceRange.baseMipLevel = region.mipLevel;
+   barrier.subresourceRange.levelCount = 1;
+   barrier.subresourceRange.baseArrayLayer = region.arrayLayer;
+   barrier.subresourceRange.layerCount = 1;
+   return barrier;
+}
+
+} // namespace ::
+
+namespace dei::render {
+
+auto CreateUploadQueue(VulkanContext& context, VkDeviceSize stagingBytes) -> b8 {
+   auto* allocator = platform::GetVulkanAllocationCallbacks();
+   auto& uploads = context.uploads;
+   // the buffer spans the whole ring, a size this coarse needs no padding for any buffer alignment drivers report
+   constexpr auto granularity = ::STAGING_SIZE_GRANULARITY;
+   stagingBytes = (stagingBytes + granularity - 1) / granularity * granularity;
+   auto maybeStaging = CreateGpuRingPool(context.memory, stagingBytes,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+   if (maybeStaging == std::nullopt) {
+      return false;
+   }
+   uploads.staging = *maybeStaging;
+
+   auto bufferInfo = VkBufferCreateInfo{};
+   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+   bufferInfo.pNext = nullptr;
+   bufferInfo.flags = 0;
+   bufferInfo.size = uploads.staging.size;
+   bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+   bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+   bufferInfo.queueFamilyIndexCount = 0;
+   bufferInfo.pQueueFamilyIndices = nullptr;
+   if (vkCreateBuffer(context.device, &bufferInfo, allocator, &uploads.stagingBuffer) != VK_SUCCESS) {
+      DEI_LOG_ERROR("Upload: can't create the staging buffer\n");
+      return false;
+   }
+   auto requirements = VkMemoryRequirements{};
+   vkGetBufferMemoryRequirements(context.device, uploads.stagingBuffer, &requirements);
+   if ((requirements.memoryTypeBits & (1u << uploads.staging.memoryType)) == 0) {
+      DEI_LOG_ERROR("Upload: the staging ring's memory type %u can't back a buffer\n", uploads.staging.memoryType);
+      return false;
+   }
+   if (requirements.size > uploads.staging.size
+       || vkBindBufferMemory(context.device, uploads.stagingBuffer, uploads.staging.memory, 0) != VK_SUCCESS) {
+      DEI_LOG_ERROR("Upload: the staging buffer needs %lu bytes, the ring has %lu\n",
+         requirements.size, uploads.staging.size);
+      return false;
+   }
+
+   auto poolInfo = VkCommandPoolCreateInfo{};
+   poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+   poolInfo.pNext = nullptr;
+   poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+   poolInfo.queueFamilyIndex = context.queueFamilies.transfer;
+   if (vkCreateCommandPool(context.device, &poolInfo, allocator, &uploads.commandPool) != VK_SUCCESS) {
+      DEI_LOG_ERROR("Upload: can't create the transfer command pool\n");
+      return false;
+   }
+   VkCommandBuffer commandBuffers[UPLOAD_MAX_BATCHES];
+   auto allocateInfo = VkCommandBufferAllocateInfo{};
+   allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+   allocateInfo.pNext = nullptr;
+   allocateInfo.commandPool = uploads.commandPool;
+   allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+   allocateInfo.commandBufferCount = UPLOAD_MAX_BATCHES;
+   if (vkAllocateCommandBuffers(context.device, &allocateInfo, commandBuffers) != VK_SUCCESS) {
+      DEI_LOG_ERROR("Upload: can't allocate the transfer command buffers\n");
+      return false;
+   }
+   for (u32 i = 0; i < UPLOAD_MAX_BATCHES; ++i) {
+      uploads.batches[i] = UploadBatch{ commandBuffers[i], 0 };
+   }
+
+   auto timelineInfo = VkSemaphoreTypeCreateInfo{};
+   timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+   timelineInfo.pNext = nullptr;
+   timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+   timelineInfo.initialValue = 0;
+   auto semaphoreInfo = VkSemaphoreCreateInfo{};
+   semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+   semaphoreInfo.pNext = &timelineInfo;
+   semaphoreInfo.flags = 0;
+   if (vkCreateSemaphore(context.device, &semaphoreInfo, allocator, &uploads.timeline) != VK_SUCCESS) {
+      DEI_LOG_ERROR("Upload: can't create the timeline semaphore\n");
+      return false;
+   }
+   uploads.nextValue = 1;
+
+   // optimal*Alignment are only hints, but every vendor documents them as the fast path of the copy engine
+   auto properties = VkPhysicalDeviceProperties{};
+   vkGetPhysicalDeviceProperties(context.physicalDevice, &properties);
+   uploads.offsetAlignment = std::max(properties.limits.optimalBufferCopyOffsetAlignment, VkDeviceSize{4});
+   uploads.rowPitchAlignment = std::max(properties.limits.optimalBufferCopyRowPitchAlignment, VkDeviceSize{1});
+
+   uploads.bufferReleases.reserve(::UPLOAD_RESERVED_BARRIERS);
+   uploads.imageReleases.reserve(::UPLOAD_RESERVED_BARRIERS);
+   uploads.bufferAcquires.reserve(::UPLOAD_RESERVED_BARRIERS);
+   uploads.imageAcquires.reserve(::UPLOAD_RESERVED_BARRIERS);
+   DEI_LOG_INFO("Upload: %lu KiB staging ring on the %s transfer queue, copy alignment offset=%lu row pitch=%lu\n",
+      uploads.staging.size >> 10, context.queueFamilies.hasDedicatedTransfer ? "dedicated" : "graphics",
+      uploads.offsetAlignment, uploads.rowPitchAlignment);
+   return true;
+}
+
+auto DestroyUploadQueue(VulkanContext& context) -> void {
+   auto* allocator = platform::GetVulkanAllocationCallbacks();
+   auto& uploads = context.uploads;
+   if (context.device == VK_NULL_HANDLE) {
+      return;
+   }
+   vkDeviceWaitIdle(context.device);
+   if (uploads.timeline != VK_NULL_HANDLE) {
+      vkDestroySemaphore(context.device, uploads.timeline, allocator);
+   }
+   if (uploads.commandPool != VK_NULL_HANDLE) {
+      // frees the command buffers too
+      vkDestroyCommandPool(context.device, uploads.commandPool, allocator);
+   }
+   if (uploads.stagingBuffer != VK_NULL_HANDLE) {
+      vkDestroyBuffer(context.device, uploads.stagingBuffer, allocator);
+   }
+   DestroyGpuRingPool(context.memory, uploads.staging);
+   uploads = UploadQueue{};
+}
+
+auto UploadBuffer(VulkanContext& context, VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+   -> std::optional<UploadTicket> {
+   auto& uploads = context.uploads;
+   // a zero-sized copy or barrier is invalid usage, there's nothing to wait for
+   if (size == 0) {
+      return UploadTicket{ uploads.completedValue };
+   }
+   auto staging = ::AllocateStaging(context, size, uploads.offsetAlignment);
+   if (staging == std::nullopt) {
+      return std::nullopt;
+   }
+   std::memcpy(staging->mapped, data, size);
+   GpuRingPoolFlush(context.device, uploads.staging, *staging);
+
+   auto commandBuffer = uploads.batches[uploads.batchIndex].commandBuffer;
+   auto region = VkBufferCopy{ staging->offset, dstOffset, size };
+   vkCmdCopyBuffer(commandBuffer, uploads.stagingBuffer, dst, 1, &region);
+   if (::HasOwnershipTransfer(context)) {
+      // the semaphore alone orders the copy with the graphics queue when it's the same family
+      auto barrier = VkBufferMemoryBarrier{};
+      barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      barrier.pNext = nullptr;
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.dstAccessMask = 0;
+      barrier.srcQueueFamilyIndex = context.queueFamilies.transfer;
+      barrier.dstQueueFamilyIndex = context.queueFamilies.graphics;
+      barrier.buffer = dst;
+      barrier.offset = dstOffset;
+      barrier.size = size;
+      uploads.bufferReleases.push_back(barrier);
+   }
+   ++uploads.numBatchCopies;
+   uploads.uploadedBytes += size;
+   return UploadTicket{ uploads.nextValue };
+}
+
+auto UploadImage(VulkanContext& context, VkImage dst, const UploadImageRegion& region, const void* data)
+   -> std::optional<UploadTicket> {
+   auto& uploads = context.uploads;
+   if (region.extent.width == 0 || region.extent.height == 0 || region.extent.depth == 0 || region.texelBytes == 0) {
+      return UploadTicket{ uploads.completedValue };
+   }
+   // rows are addressed in texels, so the pitch is a whole number of them, as is the offset
+   auto texelBytes = VkDeviceSize{region.texelBytes};
+   auto rowBytes = texelBytes * region.extent.width;
+   auto rowPitch = (rowBytes + uploads.rowPitchAlignment - 1) / uploads.rowPitchAlignment * uploads.rowPitchAlignment;
+   rowPitch = (rowPitch + texelBytes - 1) / texelBytes * texelBytes;
+   auto numRows = VkDeviceSize{region.extent.height} * region.extent.depth;
+   auto staging = ::AllocateStaging(context, rowPitch * numRows, std::lcm(uploads.offsetAlignment, texelBytes));
+   if (staging == std::nullopt) {
+      return std::nullopt;
+   }
+   const auto* source = static_cast<const u8*>(data);
+   if (rowPitch == rowBytes) {
+      std::memcpy(staging->mapped, source, rowBytes * numRows);
+   } else {
+      for (VkDeviceSize row = 0; row < numRows; ++row) {
+         std::memcpy(staging->mapped + row * rowPitch, source + row * rowBytes, rowBytes);
+      }
+   }
+   GpuRingPoolFlush(context.device, uploads.staging, *staging);
+
+   auto commandBuffer = uploads.batches[uploads.batchIndex].commandBuffer;
+   auto toTransfer = ::MakeImageBarrier(dst, region);
+   toTransfer.srcAccessMask = 0;
+   toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+   toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+   toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+   vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+      0, nullptr, 0, nullptr, 1, &toTransfer);
+
+   auto copy = VkBufferImageCopy{};
+   copy.bufferOffset = staging->offset;
+   copy.bufferRowLength = static_cast<u32>(rowPitch / texelBytes);
+   copy.bufferImageHeight = 0;
+   copy.imageSubresource.aspectMask = region.aspect;
+   copy.imageSubresource.mipLevel = region.mipLevel;
+   copy.imageSubresource.baseArrayLayer = region.arrayLayer;
+   copy.imageSubresource.layerCount = 1;
+   copy.imageOffset = VkOffset3D{ 0, 0, 0 };
+   copy.imageExtent = region.extent;
+   vkCmdCopyBufferToImage(commandBuffer, uploads.stagingBuffer, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+
+   // the layout transition happens once, in the release, the acquire repeats the same layouts
+   auto release = ::MakeImageBarrier(dst, region);
+   release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+   release.dstAccessMask = 0;
+   release.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+   release.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+   if (::HasOwnershipTransfer(context)) {
+      release.srcQueueFamilyIndex = context.queueFamilies.transfer;
+      release.dstQueueFamilyIndex = context.queueFamilies.graphics;
+   }
+   uploads.imageReleases.push_back(release);
+   ++uploads.numBatchCopies;
+   uploads.uploadedBytes += rowBytes * numRows;
+   return UploadTicket{ uploads.nextValue };
+}
+
+auto UploadIsComplete(VulkanContext& context, UploadTicket ticket) -> b8 {
+   return ticket.timelineValue <= context.uploads.completedValue
+      || ticket.timelineValue <= ::RefreshCompletedValue(context);
+}
+
+auto UploadQueueSubmit(VulkanContext& context) -> b8 {
+   auto& uploads = context.uploads;
+   if (!uploads.isRecording || uploads.numBatchCopies == 0) {
+      return true;
+   }
+   auto& batch = uploads.batches[uploads.batchIndex];
+   if (!uploads.bufferReleases.empty() || !uploads.imageReleases.empty()) {
+      vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+         0, nullptr,
+         static_cast<u32>(uploads.bufferReleases.size()), uploads.bufferReleases.data(),
+         static_cast<u32>(uploads.imageReleases.size()), uploads.imageReleases.data());
+   }
+   vkEndCommandBuffer(batch.commandBuffer);
+
+   auto value = uploads.nextValue;
+   auto timelineInfo = VkTimelineSemaphoreSubmitInfo{};
+   timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+   timelineInfo.pNext = nullptr;
+   timelineInfo.waitSemaphoreValueCount = 0;
+   timelineInfo.pWaitSemaphoreValues = nullptr;
+   timelineInfo.signalSemaphoreValueCount = 1;
+   timelineInfo.pSignalSemaphoreValues = &value;
+   auto submitInfo = VkSubmitInfo{};
+   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+   submitInfo.pNext = &timelineInfo;
+   submitInfo.waitSemaphoreCount = 0;
+   submitInfo.pWaitSemaphores = nullptr;
+   submitInfo.pWaitDstStageMask = nullptr;
+   submitInfo.commandBufferCount = 1;
+   submitInfo.pCommandBuffers = &batch.commandBuffer;
+   submitInfo.signalSemaphoreCount = 1;
+   submitInfo.pSignalSemaphores = &uploads.timeline;
+   auto result = vkQueueSubmit(context.transferQueue, 1, &submitInfo, VK_NULL_HANDLE);
+   if (result != VK_SUCCESS) {
+      DEI_LOG_ERROR("Upload: vkQueueSubmit failed (%d)\n", result);
+      return false;
+   }
+
+   if (::HasOwnershipTransfer(context)) {
+      for (auto barrier : uploads.bufferReleases) {
+         barrier.srcAccessMask = 0;
+         barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+         uploads.bufferAcquires.push_back(barrier);
+      }
+      for (auto barrier : uploads.imageReleases) {
+         barrier.srcAccessMask = 0;
+         barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+         uploads.imageAcquires.push_back(barrier);
+      }
+   }
+   uploads.bufferReleases.clear();
+   uploads.imageReleases.clear();
+   batch.timelineValue = value;
+   uploads.submittedValue = value;
+   ++uploads.nextValue;
+   ++uploads.numSubmittedBatches;
+   uploads.isRecording = false;
+   uploads.batchIndex = (uploads.batchIndex + 1) % UPLOAD_MAX_BATCHES;
+   return true;
+}
+
+auto UploadRecordAcquires(VulkanContext& context, VkCommandBuffer commandBuffer) -> void {
+   auto& uploads = context.uploads;
+   // the frame's submission waits for every batch submitted so far, which releases what's acquired here
+   uploads.frameWaitValue = uploads.submittedValue;
+   if (uploads.bufferAcquires.empty() && uploads.imageAcquires.empty()) {
+      return;
+   }
+   vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+      0, nullptr,
+      static_cast<u32>(uploads.bufferAcquires.size()), uploads.bufferAcquires.data(),
+      static_cast<u32>(uploads.imageAcquires.size()), uploads.imageAcquires.data());
+   uploads.bufferAcquires.clear();
+   uploads.imageAcquires.clear();
+}
+
+auto PrintUploadQueueStats(const UploadQueue& uploads) -> void {
+   DEI_LOG_INFO("Upload: batches=%lu uploaded=%lu KiB deferred=%lu completed value=%lu/%lu\n",
+      uploads.numSubmittedBatches, uploads.uploadedBytes >> 10, uploads.numDeferred,
+      uploads.completedValue, uploads.submittedValue);
+}
+
+} // namespace dei
@@ -1,4 +1,10 @@
 #include "dei/Vulkan.hpp"
+#include "dei/Swapchain.hpp"
+#include "dei_platform/Log.hpp"
+#include "dei_platform/VulkanAllocator.hpp"
+
+#include <algorithm>
+#include <cstring>
 
 #define DEI_IS_BOOL_SATISFIED(REQ,ACTUAL,FIELD) (REQ.FIELD == ACTUAL.FIELD || REQ.FIELD == 0)
 
@@ -175,9 +181,9 @@ b8 VerifyVkPhysicalLimits(const VkPhysicalDeviceLimits& required, const VkPhysic
    result &= (required.standardSampleLocations == actual.standardSampleLocations
       || required.standardSampleLocations == VK_FALSE);
    return result;
+      // optimalBufferCopyOffsetAlignment and optimalBufferCopyRowPitchAlignment are hints, not limits,
+      // the upload queue aligns its staging copies to them
       // FIXME: not sure how to compare against (min or max)
-      //  VkDeviceSize          optimalBufferCopyOffsetAlignment;
-      //  VkDeviceSize          optimalBufferCopyRowPitchAlignment;
       //  VkDeviceSize          nonCoherentAtomSize;
 }
 
@@ -288,6 +294,41 @@ auto QueryAndFilterPhysicalDevice(
    return std::move(satisfiedDevices);
 }
 
+constexpr u32 NO_QUEUE_FAMILY = VK_QUEUE_FAMILY_IGNORED;
+constexpr const char* REQUIRED_DEVICE_EXTENSIONS[] = {
+   VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+};
+// enabled when all are supported
+constexpr const char* PRESENT_WAIT_DEVICE_EXTENSIONS[] = {
+   VK_KHR_PRESENT_ID_EXTENSION_NAME,
+   VK_KHR_PRESENT_WAIT_EXTENSION_NAME,
+};
+
+auto QueryDeviceExtensions(VkPhysicalDevice device) -> std::vector<VkExtensionProperties> {
+   auto numExtensions = u32{0};
+   vkEnumerateDeviceExtensionProperties(device, nullptr, &numExtensions, nullptr);
+   auto extensions = std::vector<VkExtensionProperties>(numExtensions);
+   vkEnumerateDeviceExtensionProperties(device, nullptr, &numExtensions, extensions.data());
+   return extensions;
+}
+
+auto ContainsExtension(const std::vector<VkExtensionProperties>& extensions, const char* name) -> b8 {
+   return std::any_of(extensions.begin(), extensions.end(), [&](const VkExtensionProperties& extension) {
+      return std::strcmp(extension.extensionName, name) == 0;
+   });
+}
+
+// the first family whose flags contain all of required and none of excluded
+auto FindQueueFamily(const std::vector<VkQueueFamilyProperties>& families, VkQueueFlags required, VkQueueFlags excluded) -> u32 {
+   for (u32 i = 0; i < families.size(); ++i) {
+      auto flags = families[i].queueFlags;
+      if (families[i].queueCount > 0 && (flags & required) == required && (flags & excluded) == 0) {
+         return i;
+      }
+   }
+   return NO_QUEUE_FAMILY;
+}
+
 } // namespace ::
 
 namespace dei::render {
@@ -313,7 +354,7 @@ auto CreateVulkanInstance(const char** requiredExtensions, u32 requiredExtension
    info.flags = 0; //VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
 
    auto instance = VkInstance{};
-   auto result = vkCreateInstance(&info, nullptr, &instance);
+   auto result = vkCreateInstance(&info, dei::platform::GetVulkanAllocationCallbacks(), &instance);
    (void)result;
    return instance;
 }
@@ -394,21 +435,21 @@ auto PhysicalDevice::HasLimits(const VkPhysicalDeviceLimits& requiredLimits) con
 
 auto PrintPhysicalDevice(const PhysicalDevice& device) -> void {
    const auto& properties = device.GetProperties();
-   printf("Physical device: %s\n", device.GetDeviceTypeName());
-   printf(" - Vendor       : %s\n", device.GetVendorName());
-   printf(" - Name         : %s\n", properties.deviceName);
-   printf(" - Version      : %d\n", properties.driverVersion);
-   printf(" - API Version  : %d.%d.%d\n",
+   DEI_LOG_INFO("Physical device: %s\n", device.GetDeviceTypeName());
+   DEI_LOG_INFO(" - Vendor       : %s\n", device.GetVendorName());
+   DEI_LOG_INFO(" - Name         : %s\n", properties.deviceName);
+   DEI_LOG_INFO(" - Version      : %d\n", properties.driverVersion);
+   DEI_LOG_INFO(" - API Version  : %d.%d.%d\n",
       VK_API_VERSION_MAJOR(properties.apiVersion),
       VK_API_VERSION_MINOR(properties.apiVersion),
       VK_API_VERSION_PATCH(properties.apiVersion));
-   printf(" - Max Framebuffer : %d x %d\n",
+   DEI_LOG_INFO(" - Max Framebuffer : %d x %d\n",
       properties.limits.maxFramebufferWidth,
       properties.limits.maxFramebufferHeight);
-   printf(" - Min Texel Offset : %d\n", properties.limits.minTexelOffset);
-   printf(" - Min Texel Gather Offset : %d\n", properties.limits.minTexelGatherOffset);
-   printf(" - Max Image2D Dimension : %d\n", properties.limits.maxImageDimension2D);
-   printf(" - Max Vertex Attributes: %d\n", properties.limits.maxVertexInputAttributes);
+   DEI_LOG_INFO(" - Min Texel Offset : %d\n", properties.limits.minTexelOffset);
+   DEI_LOG_INFO(" - Min Texel Gather Offset : %d\n", properties.limits.minTexelGatherOffset);
+   DEI_LOG_INFO(" - Max Image2D Dimension : %d\n", properties.limits.maxImageDimension2D);
+   DEI_LOG_INFO(" - Max Vertex Attributes: %d\n", properties.limits.maxVertexInputAttributes);
 
    // TODO: can simply convert to int
    u32 maxFramebufferSamples = {};
@@ -422,7 +463,209 @@ auto PrintPhysicalDevice(const PhysicalDevice& device) -> void {
       case VK_SAMPLE_COUNT_64_BIT: maxFramebufferSamples = 64; break;
       case VK_SAMPLE_COUNT_FLAG_BITS_MAX_ENUM: maxFramebufferSamples = 0; break;
    }
-   printf(" - Max Framebuffer Samples : %d\n", maxFramebufferSamples);
+   DEI_LOG_INFO(" - Max Framebuffer Samples : %d\n", maxFramebufferSamples);
+}
+
+auto HasRequiredDeviceExtensions(VkPhysicalDevice device) -> b8 {
+   auto extensions = ::QueryDeviceExtensions(device);
+   for (const auto* required : ::REQUIRED_DEVICE_EXTENSIONS) {
+      if (!::ContainsExtension(extensions, required)) {
+         DEI_LOG_WARN("Vulkan: device extension %s isn't supported\n", required);
+         return false;
+      }
+   }
+   return true;
+}
+
+auto HasTimelineSemaphores(VkPhysicalDevice device) -> b8 {
+   auto timelineFeatures = VkPhysicalDeviceTimelineSemaphoreFeatures{};
+   timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+   timelineFeatures.pNext = nullptr;
+   timelineFeatures.timelineSemaphore = VK_FALSE;
+   auto supportedFeatures = VkPhysicalDeviceFeatures2{};
+   supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+   supportedFeatures.pNext = &timelineFeatures;
+   vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
+   return timelineFeatures.timelineSemaphore != VK_FALSE;
+}
+
+auto HasPresentWait(VkPhysicalDevice device) -> b8 {
+   auto extensions = ::QueryDeviceExtensions(device);
+   for (const auto* optional : ::PRESENT_WAIT_DEVICE_EXTENSIONS) {
+      if (!::ContainsExtension(extensions, optional)) {
+         return false;
+      }
+   }
+   auto presentIdFeatures = VkPhysicalDevicePresentIdFeaturesKHR{};
+   presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+   presentIdFeatures.pNext = nullptr;
+   presentIdFeatures.presentId = VK_FALSE;
+   auto presentWaitFeatures = VkPhysicalDevicePresentWaitFeaturesKHR{};
+   presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+   presentWaitFeatures.pNext = &presentIdFeatures;
+   presentWaitFeatures.presentWait = VK_FALSE;
+   auto supportedFeatures = VkPhysicalDeviceFeatures2{};
+   supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+   supportedFeatures.pNext = &presentWaitFeatures;
+   vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
+   return presentIdFeatures.presentId != VK_FALSE && presentWaitFeatures.presentWait != VK_FALSE;
+}
+
+auto FindQueueFamilies(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface) -> std::optional<QueueFamilies> {
+   auto numFamilies = u32{0};
+   vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &numFamilies, nullptr);
+   auto families = std::vector<VkQueueFamilyProperties>(numFamilies);
+   vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &numFamilies, families.data());
+   auto canPresent = [&](u32 family) {
+      auto isSupported = VkBool32{VK_FALSE};
+      return vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, family, surface, &isSupported) == VK_SUCCESS
+         && isSupported == VK_TRUE;
+   };
+
+   auto result = QueueFamilies{ ::NO_QUEUE_FAMILY, ::NO_QUEUE_FAMILY, ::NO_QUEUE_FAMILY, ::NO_QUEUE_FAMILY, false, false };
+   // graphics and present in one family avoid ownership transfers of swapchain images
+   for (u32 i = 0; i < numFamilies; ++i) {
+      if (families[i].queueCount > 0 && (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) && canPresent(i)) {
+         result.graphics = result.present = i;
+         break;
+      }
+   }
+   if (result.graphics == ::NO_QUEUE_FAMILY) {
+      result.graphics = ::FindQueueFamily(families, VK_QUEUE_GRAPHICS_BIT, 0);
+      for (u32 i = 0; i < numFamilies && result.present == ::NO_QUEUE_FAMILY; ++i) {
+         if (families[i].queueCount > 0 && canPresent(i)) {
+            result.present = i;
+         }
+      }
+   }
+   if (result.graphics == ::NO_QUEUE_FAMILY || result.present == ::NO_QUEUE_FAMILY) {
+      return std::nullopt;
+   }
+
+   // async compute: a compute family without graphics
+   result.compute = ::FindQueueFamily(families, VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT);
+   result.hasDedicatedCompute = result.compute != ::NO_QUEUE_FAMILY;
+   if (!result.hasDedicatedCompute) {
+      result.compute = result.graphics;
+   }
+   // DMA engine: a transfer family without graphics and compute
+   result.transfer = ::FindQueueFamily(families, VK_QUEUE_TRANSFER_BIT, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+   result.hasDedicatedTransfer = result.transfer != ::NO_QUEUE_FAMILY;
+   if (!result.hasDedicatedTransfer) {
+      // graphics and compute families support transfers implicitly
+      result.transfer = result.compute;
+   }
+   return result;
+}
+
+auto CreateVulkanDevice(VulkanContext& context, const VkPhysicalDeviceFeatures& enabledFeatures) -> b8 {
+   if (!HasRequiredDeviceExtensions(context.physicalDevice)) {
+      return false;
+   }
+   auto maybeFamilies = FindQueueFamilies(context.physicalDevice, context.windowSurface);
+   if (maybeFamilies == std::nullopt) {
+      DEI_LOG_ERROR("Vulkan: the device has no graphics queue or can't present to the window\n");
+      return false;
+   }
+   const auto& families = *maybeFamilies;
+   if (!HasTimelineSemaphores(context.physicalDevice)) {
+      DEI_LOG_ERROR("Vulkan: the device doesn't support timeline semaphores\n");
+      return false;
+   }
+   auto timelineFeatures = VkPhysicalDeviceTimelineSemaphoreFeatures{};
+   timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+   timelineFeatures.pNext = nullptr;
+   timelineFeatures.timelineSemaphore = VK_TRUE;
+   auto hasPresentWait = HasPresentWait(context.physicalDevice);
+   auto presentIdFeatures = VkPhysicalDevicePresentIdFeaturesKHR{};
+   presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+   presentIdFeatures.pNext = nullptr;
+   presentIdFeatures.presentId = VK_TRUE;
+   auto presentWaitFeatures = VkPhysicalDevicePresentWaitFeaturesKHR{};
+   presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+   presentWaitFeatures.pNext = &presentIdFeatures;
+   presentWaitFeatures.presentWait = VK_TRUE;
+   timelineFeatures.pNext = hasPresentWait ? &presentWaitFeatures : nullptr;
+   auto enabledExtensions = std::vector<const char*>(
+      std::begin(::REQUIRED_DEVICE_EXTENSIONS), std::end(::REQUIRED_DEVICE_EXTENSIONS));
+   if (hasPresentWait) {
+      enabledExtensions.insert(enabledExtensions.end(),
+         std::begin(::PRESENT_WAIT_DEVICE_EXTENSIONS), std::end(::PRESENT_WAIT_DEVICE_EXTENSIONS));
+   }
+
+   constexpr f32 QUEUE_PRIORITY = 1.0f;
+   u32 distinctFamilies[4];
+   u32 numDistinctFamilies = 0;
+   auto queueInfos = std::vector<VkDeviceQueueCreateInfo>{};
+   for (auto family : {families.graphics, families.present, families.compute, families.transfer}) {
+      if (std::find(distinctFamilies, distinctFamilies + numDistinctFamilies, family) != distinctFamilies + numDistinctFamilies) {
+         continue;
+      }
+      distinctFamilies[numDistinctFamilies++] = family;
+      auto queueInfo = VkDeviceQueueCreateInfo{};
+      queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+      queueInfo.pNext = nullptr;
+      queueInfo.flags = 0;
+      queueInfo.queueFamilyIndex = family;
+      queueInfo.queueCount = 1;
+      queueInfo.pQueuePriorities = &QUEUE_PRIORITY;
+      queueInfos.push_back(queueInfo);
+   }
+
+   auto info = VkDeviceCreateInfo{};
+   info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+   info.pNext = &timelineFeatures;
+   info.flags = 0;
+   info.queueCreateInfoCount = static_cast<u32>(queueInfos.size());
+   info.pQueueCreateInfos = queueInfos.data();
+   info.enabledLayerCount = 0;
+   info.ppEnabledLayerNames = nullptr;
+   info.enabledExtensionCount = static_cast<u32>(enabledExtensions.size());
+   info.ppEnabledExtensionNames = enabledExtensions.data();
+   info.pEnabledFeatures = &enabledFeatures;
+
+   auto device = VkDevice{};
+   auto result = vkCreateDevice(context.physicalDevice, &info, dei::platform::GetVulkanAllocationCallbacks(), &device);
+   if (result != VK_SUCCESS) {
+      DEI_LOG_ERROR("Vulkan: vkCreateDevice failed (%d)\n", result);
+      return false;
+   }
+   context.device = device;
+   context.queueFamilies = families;
+   context.memory = CreateGpuMemory(context.physicalDevice, device);
+   vkGetDeviceQueue(device, families.graphics, 0, &context.graphicsQueue);
+   vkGetDeviceQueue(device, families.present, 0, &context.presentQueue);
+   vkGetDeviceQueue(device, families.compute, 0, &context.computeQueue);
+   vkGetDeviceQueue(device, families.transfer, 0, &context.transferQueue);
+   context.waitForPresent = hasPresentWait
+      ? reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(device, "vkWaitForPresentKHR"))
+      : nullptr;
+   context.lastPresentId = 0;
+   DEI_LOG_INFO("Vulkan: input-to-photon latency measured at %s\n",
+      context.waitForPresent != nullptr ? "presentation (VK_KHR_present_wait)" : "GPU completion (fences)");
+   DEI_LOG_INFO("Queue families: graphics=%u present=%u compute=%u%s transfer=%u%s\n",
+      families.graphics, families.present,
+      families.compute, families.hasDedicatedCompute ? " (async)" : "",
+      families.transfer, families.hasDedicatedTransfer ? " (dedicated)" : "");
+   return true;
+}
+
+auto DestroyVulkanContext(VulkanContext& context) -> void {
+   auto* allocator = platform::GetVulkanAllocationCallbacks();
+   if (context.device != VK_NULL_HANDLE) {
+      StopPresentWaiter(context);
+      DestroySwapchain(context);
+      DestroyUploadQueue(context);
+      DestroyGpuMemory(context.memory);
+      vkDestroyDevice(context.device, allocator);
+   }
+   if (context.windowSurface != VK_NULL_HANDLE) {
+      vkDestroySurfaceKHR(context.instance, context.windowSurface, allocator);
+   }
+   if (context.instance != VK_NULL_HANDLE) {
+      vkDestroyInstance(context.instance, allocator);
+   }
+   context = VulkanContext{};
 }
 
 } // namespace dei
\ No newline at end of file
@@ -8,7 +8,12 @@ b8 EngineColdStartup(EngineState& destinationState, const EngineDependencies& de
 
 b8 EngineHotStartup(EngineState& engineState);
 
-b8 EngineTick(EngineState& engineState);
+b8 EngineTick(EngineState& engineState, const EngineDependencies& dependencies);
+
+b8 EngineSimulate(EngineState& engineState, f64 fixedDeltaSec);
+
+// alpha in [0, 1] blends the previous and the current simulation states
+b8 EngineRender(EngineState& engineState, const EngineDependencies& dependencies, f64 alpha);
 
 b8 EngineReleaseResources(EngineState& engineState);
 
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "dei_platform/TypesFwd.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <optional>
+#include <vector>
+
+namespace dei::render {
+
+// vkAllocateMemory size of the blocks sub-allocated by the buddy allocator, a power of 2
+constexpr VkDeviceSize GPU_MEMORY_BLOCK_BYTES = 64ULL << 20;
+// the smallest buddy node, smaller allocations waste the rest of it
+constexpr u32 GPU_MEMORY_MIN_NODE_SHIFT = 8;
+constexpr u32 GPU_MEMORY_BLOCK_SHIFT = 26;
+static_assert((1ULL << GPU_MEMORY_BLOCK_SHIFT) == GPU_MEMORY_BLOCK_BYTES);
+constexpr u32 GPU_MEMORY_NUM_ORDERS = GPU_MEMORY_BLOCK_SHIFT - GPU_MEMORY_MIN_NODE_SHIFT + 1;
+constexpr u32 NO_MEMORY_TYPE = ~0U;
+// ring pools remember where each of this many frames ended
+constexpr u32 GPU_RING_MAX_FRAMES = 4;
+
+// Buffers and linear images are never placed next to optimal images, they use separate blocks,
+// so bufferImageGranularity never has to pad an allocation
+enum class GpuResourceKind : u8 {
+   LINEAR,
+   OPTIMAL_IMAGE,
+};
+
+struct GpuAllocation {
+   VkDeviceMemory memory;
+   VkDeviceSize offset;
+   VkDeviceSize size;
+   // null unless the memory type is host visible
+   u8* mapped;
+   u32 memoryType;
+   // into GpuMemory::pools, unused for dedicated and ring allocations
+   u32 poolIndex;
+   u32 blockIndex;
+   u8 order;
+   b8 isDedicated;
+};
+
+// a block carved up by a binary buddy allocator: a node of order k is GPU_MEMORY_MIN_NODE_SHIFT + k bits
+// in size and aligned to it, freeing merges it with its free buddy
+struct GpuBuddyBlock {
+   VkDeviceMemory memory;
+   u8* mapped;
+   VkDeviceSize usedBytes;
+   u32 numAllocations;
+   // free node indices of every order, may contain nodes merged meanwhile, which freeBits tells apart
+   std::vector<u32> freeNodes[GPU_MEMORY_NUM_ORDERS];
+   std::vector<u64> freeBits[GPU_MEMORY_NUM_ORDERS];
+};
+
+// long-lived allocations of one memory type and resource kind
+struct GpuMemoryPool {
+   u32 memoryType;
+   GpuResourceKind kind;
+   std::vector<GpuBuddyBlock> blocks;
+};
+
+// Device memory of one VkDevice: few large vkAllocateMemory blocks, sub-allocated per memory type.
+// Not thread safe
+struct GpuMemory {
+   VkDevice device;
+   VkPhysicalDeviceMemoryProperties properties;
+   VkDeviceSize nonCoherentAtomSize;
+   u32 maxDeviceAllocations;
+   u32 numDeviceAllocations;
+   std::vector<GpuMemoryPool> pools;
+   VkDeviceSize reservedBytes[VK_MAX_MEMORY_TYPES];
+   VkDeviceSize dedicatedBytes[VK_MAX_MEMORY_TYPES];
+   u32 numDedicated[VK_MAX_MEMORY_TYPES];
+};
+
+// Transient data (staging, per frame constants): allocations only advance the head, the memory of a frame
+// is reused once its fence signaled, see GpuRingPoolBeginFrame. Persistently mapped
+struct GpuRingPool {
+   VkDeviceMemory memory;
+   u8* mapped;
+   VkDeviceSize size;
+   // both only grow, the position in the ring is modulo size
+   VkDeviceSize head;
+   VkDeviceSize tail;
+   VkDeviceSize frameEnds[GPU_RING_MAX_FRAMES];
+   VkDeviceSize atomSize;
+   u32 memoryType;
+   u32 frameIndex;
+   b8 isCoherent;
+};
+
+struct GpuMemoryStats {
+   u32 numBlocks;
+   u32 numAllocations;
+   u32 numDedicated;
+   VkDeviceSize reservedBytes;
+   VkDeviceSize usedBytes;
+   // the largest allocation that would fit without a new block
+   VkDeviceSize largestFreeBytes;
+   // 0 when the free memory of every block is one range, approaching 1 when it's scattered in small ranges
+   f32 fragmentation;
+};
+
+auto CreateGpuMemory(VkPhysicalDevice, VkDevice) -> GpuMemory;
+// frees every block, allocations still alive become dangling
+auto DestroyGpuMemory(GpuMemory&) -> void;
+
+// the first type in typeBits with the required properties, preferring the ones with the preferred properties too
+auto GpuMemoryFindType(const GpuMemory&, u32 typeBits, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+   -> u32;
+// long-lived memory: a buddy node, or a dedicated vkAllocateMemory for more than half a block
+auto GpuMemoryAllocate(GpuMemory&, const VkMemoryRequirements&, VkMemoryPropertyFlags required,
+   VkMemoryPropertyFlags preferred, GpuResourceKind) -> std::optional<GpuAllocation>;
+auto GpuMemoryFree(GpuMemory&, const GpuAllocation&) -> void;
+// memoryType NO_MEMORY_TYPE sums all the types
+auto GpuMemoryQueryStats(const GpuMemory&, u32 memoryType) -> GpuMemoryStats;
+auto PrintGpuMemoryStats(const GpuMemory&) -> void;
+
+// a dedicated block of a host visible type
+auto CreateGpuRingPool(GpuMemory&, VkDeviceSize size, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred)
+   -> std::optional<GpuRingPool>;
+auto DestroyGpuRingPool(GpuMemory&, GpuRingPool&) -> void;
+// call after the fence of frameIndex (< GPU_RING_MAX_FRAMES) signaled: what that frame allocated last time
+// becomes free, so always passing 0 makes a linear pool reset every frame
+auto GpuRingPoolBeginFrame(GpuRingPool&, u32 frameIndex) -> void;
+// nullopt if the frames in flight hold the whole ring
+auto GpuRingPoolAllocate(GpuRingPool&, VkDeviceSize size, VkDeviceSize alignment) -> std::optional<GpuAllocation>;
+// makes CPU writes visible to the device, a no-op for coherent memory
+auto GpuRingPoolFlush(VkDevice, const GpuRingPool&, const GpuAllocation&) -> void;
+
+} // namespace dei
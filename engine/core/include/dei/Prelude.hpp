@@ -1,22 +1,80 @@
 #pragma once
 
 #include "dei_platform/TypesFwd.hpp"
+#include "dei_platform/TypesVec.hpp"
+#include "dei_platform/TypesMat.hpp"
+#include "dei/Timestep.hpp"
+#include "dei/Vulkan.hpp"
 
 #include <vulkan/vulkan.hpp>
 
+namespace dei::platform {
+struct FrameStats;
+struct LatencyProbe;
+struct WindowSurfaceState;
+}
+
+namespace dei::platform::input {
+struct InputEventQueue;
+struct InputSnapshot;
+struct MouseMotionAccumulator;
+}
+
 namespace dei {
 
 struct EngineDependencies {
     std::function<VkSurfaceKHR(VkInstance)> CreateVkSurfaceCallback;
     u32 RequiredHostExtensionCount;
     const char** RequiredHostExtensions;
+    // owned and recorded by the host, may be null
+    const platform::FrameStats* FrameStats;
+    // fixed rate of EngineSimulate, independent of the frame rate
+    f64 SimulationRateHz{60.0};
+    // not null if the window buffers input, drained once per tick
+    platform::input::InputEventQueue* InputEvents;
+    // latched by the host before every tick, may be null
+    const platform::input::InputSnapshot* Input;
+    // taken in EngineRender right before building the view, may be null
+    platform::input::MouseMotionAccumulator* MouseMotion;
+    // the window the swapchain presents to, nothing is presented if null
+    const platform::WindowSurfaceState* WindowSurface;
+    // 1..render::MAX_FRAMES_IN_FLIGHT, read at cold startup
+    u32 NumFramesInFlight{2};
+    // frames are reported to it once the GPU finishes them, may be null
+    platform::LatencyProbe* Latency;
+    // the clock the simulation advances to, set by the host before every tick (recorded one while replaying input),
+    // the engine reads the monotonic clock if null or 0
+    const i64* FrameNanosec;
+};
+
+// everything EngineSimulate advances, EngineRender interpolates between two consecutive copies
+struct SimulationState {
+    u64 StepIndex;
+    f64 TimeSec;
+    f32 CameraDistance;
+    vec2f CameraRotation;
 };
 
 struct EngineState {
     u32 DrawCounter{0};
-    VkSurfaceKHR WindowSurface;
-    VkInstance VulkanInstance;
-    VkPhysicalDevice PhysicalDevice;
+    // reset on every hot reload
+    u32 NumTicksSinceHotStartup{0};
+    FixedTimestep Timestep;
+    SimulationState PreviousSimulation;
+    SimulationState CurrentSimulation;
+    mat4f ViewProjection;
+    // input consumed by the next simulation step
+    f32 PendingCameraZoom;
+    // -1..1 while zoom keys are held
+    f32 CameraZoomAxis;
+    u32 NumInputEventsLastTick;
+    render::VulkanContext Vulkan;
+};
+
+// cr_plugin::userdata, owned by the host and shared with every engine library version
+struct EngineHotReloadState {
+    dei::EngineState EngineState;
+    dei::EngineDependencies EngineDependencies;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "dei/Vulkan.hpp"
+#include "dei_platform/LatencyProbe.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace dei::render {
+
+// a resize is applied once the window kept its size this long, so dragging a border
+// doesn't recreate the swapchain every frame (unless presentation reports it out of date)
+constexpr i64 SWAPCHAIN_RESIZE_DEBOUNCE_NANOSEC = 100000000LL;
+
+// a frame to wait for: its present id on swapChain, or its fence if swapChain is VK_NULL_HANDLE
+struct PresentWaitJob {
+   VkSwapchainKHR swapChain;
+   u64 presentId;
+   VkFence fence;
+   u64 latencyFrameId;
+};
+
+struct PresentWaitResult {
+   u64 latencyFrameId;
+   i64 presentNanosec;
+};
+
+// A thread blocked in vkWaitForPresentKHR (or vkWaitForFences without present wait), it takes the time as soon as
+// the wait returns, so a sample isn't delayed until the next BeginFrame polls. The frame thread pushes the jobs
+// and takes the results, the LatencyProbe stays on the frame thread. The thread runs the engine library's code,
+// it's stopped before the library is unloaded
+struct PresentWaiter {
+   VkDevice device;
+   PFN_vkWaitForPresentKHR waitForPresent;
+   std::mutex mutex; // guards everything below but isCanceled
+   std::condition_variable jobPushed;
+   std::condition_variable jobDone;
+   PresentWaitJob jobs[PRESENT_WAIT_FRAMES];
+   u64 numJobsPushed;
+   u64 numJobsDone;
+   PresentWaitResult results[PRESENT_WAIT_FRAMES];
+   u64 numResultsPushed;
+   u64 numResultsTaken;
+   b8 isRunning;
+   // the pending jobs are dropped, set while their swapchain or fences are destroyed
+   std::atomic<b8> isCanceled;
+   std::thread thread;
+};
+
+// the first of the policy's modes the surface supports, FIFO is supported everywhere
+auto ChoosePresentMode(const VkPresentModeKHR* supportedModes, u32 numSupportedModes, platform::PresentPolicy)
+   -> VkPresentModeKHR;
+// the command pool, command buffers, fences and semaphores of numFramesInFlight (clamped to 1..MAX_FRAMES_IN_FLIGHT)
+// frames, must be called before the first BeginFrame
+auto CreateFrameResources(VulkanContext&, u32 numFramesInFlight) -> b8;
+// creates context.swapChain, or recreates it from the old one, false if the surface has no area (minimized)
+auto CreateSwapchain(VulkanContext&, VkExtent2D framebufferSizePx, platform::PresentPolicy) -> b8;
+// waits for the device, then destroys the swapchain and the frame resources
+auto DestroySwapchain(VulkanContext&) -> void;
+// starts context.presentWaiter, after CreateVulkanDevice and after every reload of the engine library
+auto StartPresentWaiter(VulkanContext&) -> void;
+// drops its pending jobs and joins it, before the engine library is unloaded
+auto StopPresentWaiter(VulkanContext&) -> void;
+
+// Waits for the oldest frame in flight, (re)creates the swapchain if the window asks for it, acquires an image.
+// Returns the frame's command buffer in recording state, VK_NULL_HANDLE if nothing can be presented now.
+// Reports the frames the PresentWaiter saw presented (or finished by the GPU) to the latency probe, which may be
+// null. The command buffer starts with the acquires of the submitted upload batches
+auto BeginFrame(VulkanContext&, const platform::WindowSurfaceState&, platform::LatencyProbe*) -> VkCommandBuffer;
+// submits the command buffer and presents context.swapChainImages[context.swapChainImageIndex],
+// which the commands must leave in VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, then submits the frame's upload batch.
+// False on device errors
+auto EndFrame(VulkanContext&, platform::LatencyProbe*) -> b8;
+
+} // namespace dei
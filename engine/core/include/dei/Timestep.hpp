@@ -0,0 +1,26 @@
+#pragma once
+
+#include "dei_platform/TypesFwd.hpp"
+
+namespace dei {
+
+// Accumulates real frame time and converts it into a whole number of fixed simulation steps
+struct FixedTimestep {
+    f64 StepSec;
+    // spiral-of-death protection: longer frames are truncated and
+    // no more than MaxStepsPerFrame steps are simulated per frame
+    f64 MaxFrameSec;
+    u32 MaxStepsPerFrame;
+    f64 AccumulatorSec;
+    i64 LastFrameNanosec;
+    u64 NumSteps;
+    f64 DroppedSec;
+};
+
+auto MakeFixedTimestep(f64 simulationRateHz, u32 maxStepsPerFrame = 8, f64 maxFrameSec = 0.25) -> FixedTimestep;
+// returns the number of simulation steps to run this frame
+auto FixedTimestepAdvance(FixedTimestep&, i64 nowNanosec) -> u32;
+// how far the simulation time lags behind real time, in [0, 1) of a step
+auto FixedTimestepAlpha(const FixedTimestep&) -> f64;
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "dei_platform/TypesFwd.hpp"
+#include "dei/GpuMemory.hpp"
+
+#include <vulkan/vulkan.hpp>
+
+#include <optional>
+#include <vector>
+
+namespace dei::render {
+
+struct VulkanContext;
+
+constexpr VkDeviceSize UPLOAD_STAGING_DEFAULT_BYTES = 32ULL << 20;
+// batches that may be executing on the transfer queue at once, each reuses the staging memory
+// of the batch that was in its slot before
+constexpr u32 UPLOAD_MAX_BATCHES = GPU_RING_MAX_FRAMES;
+
+// completes when the batch the copy was recorded into finished on the transfer queue
+struct UploadTicket {
+   u64 timelineValue;
+};
+
+// a tightly packed subresource, its previous contents are discarded
+struct UploadImageRegion {
+   VkExtent3D extent;
+   u32 texelBytes;
+   u32 mipLevel;
+   u32 arrayLayer;
+   VkImageAspectFlags aspect;
+};
+
+struct UploadBatch {
+   VkCommandBuffer commandBuffer;
+   // signaled by the timeline semaphore once the batch finished, 0 if never submitted
+   u64 timelineValue;
+};
+
+// Streaming copies into device local memory: data goes through a persistently mapped staging ring,
+// the copies of a frame are recorded into one batch and submitted to the transfer queue by EndFrame.
+// The next frame acquires the resources on the graphics queue and waits on the timeline semaphore
+// instead of the CPU waiting for the copies. Not thread safe
+struct UploadQueue {
+   GpuRingPool staging;
+   VkBuffer stagingBuffer;
+   VkCommandPool commandPool;
+   VkSemaphore timeline;
+   UploadBatch batches[UPLOAD_MAX_BATCHES];
+   u32 batchIndex;
+   u32 numBatchCopies;
+   b8 isRecording;
+   // the value the recording batch will signal
+   u64 nextValue;
+   u64 submittedValue;
+   // last read of the timeline semaphore's counter
+   u64 completedValue;
+   // the current frame's graphics submission waits for it, set by UploadRecordAcquires
+   u64 frameWaitValue;
+   u64 waitedValue;
+   // ownership transfers and layout transitions, recorded at the end of the batch
+   std::vector<VkBufferMemoryBarrier> bufferReleases;
+   std::vector<VkImageMemoryBarrier> imageReleases;
+   // their counterparts on the graphics queue, for submitted batches, empty if graphics does transfers itself
+   std::vector<VkBufferMemoryBarrier> bufferAcquires;
+   std::vector<VkImageMemoryBarrier> imageAcquires;
+   VkDeviceSize offsetAlignment;
+   VkDeviceSize rowPitchAlignment;
+   u64 numSubmittedBatches;
+   u64 uploadedBytes;
+   // uploads refused because the staging ring or every batch slot was busy
+   u64 numDeferred;
+};
+
+// the staging ring, command buffers and timeline semaphore, CreateVulkanDevice must have enabled timeline semaphores
+auto CreateUploadQueue(VulkanContext&, VkDeviceSize stagingBytes) -> b8;
+// waits for the device, uploads that weren't submitted are dropped
+auto DestroyUploadQueue(VulkanContext&) -> void;
+
+// Copies data to the staging ring and records its copy to dst, which must have been created with TRANSFER_DST usage.
+// nullopt if the staging ring is full or the transfer queue is UPLOAD_MAX_BATCHES batches behind, try again
+// next frame (data larger than the ring never fits, split it). dst may be used by the frames begun after
+// the one that submitted the copy. Nothing is recorded for size 0, the ticket is complete right away
+auto UploadBuffer(VulkanContext&, VkBuffer dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size)
+   -> std::optional<UploadTicket>;
+// like UploadBuffer, the subresource ends up in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+// an empty extent records nothing (and leaves the layout as it was)
+auto UploadImage(VulkanContext&, VkImage dst, const UploadImageRegion&, const void* data)
+   -> std::optional<UploadTicket>;
+// never blocks, true once the copy finished on the transfer queue
+auto UploadIsComplete(VulkanContext&, UploadTicket) -> b8;
+
+// submits the recorded batch to the transfer queue, called by EndFrame, or directly when no frame is rendered
+auto UploadQueueSubmit(VulkanContext&) -> b8;
+// records the acquires of the submitted batches into the frame's graphics command buffer, called by BeginFrame
+auto UploadRecordAcquires(VulkanContext&, VkCommandBuffer) -> void;
+auto PrintUploadQueueStats(const UploadQueue&) -> void;
+
+} // namespace dei
@@ -1,24 +1,85 @@
 #pragma once
 
-#include "dei/Prelude.hpp"
+#include "dei_platform/TypesFwd.hpp"
+#include "dei_platform/Window.hpp"
+#include "dei/GpuMemory.hpp"
+#include "dei/Upload.hpp"
 
+#include <vulkan/vulkan.hpp>
+
+#include <optional>
 #include <vector>
 
 namespace dei::render {
 
+// Queue families claimed by the logical device. Compute and transfer point at dedicated families
+// (async compute, DMA engine) when the device has them, otherwise they alias the graphics family
+// and the queues are the same VkQueue
+struct QueueFamilies {
+   u32 graphics;
+   u32 present;
+   u32 compute;
+   u32 transfer;
+   b8 hasDedicatedCompute;
+   b8 hasDedicatedTransfer;
+};
+
+// frames the CPU may record ahead of the GPU: more hide hitches, fewer cut latency
+constexpr u32 MAX_FRAMES_IN_FLIGHT = 3;
+static_assert(MAX_FRAMES_IN_FLIGHT <= GPU_RING_MAX_FRAMES);
+// frames the PresentWaiter waits for at once, later frames aren't measured until it catches up
+constexpr u32 PRESENT_WAIT_FRAMES = 8;
+constexpr u64 NO_PRESENT_WAIT_JOB = ~0ULL;
+
+// synchronization of one frame slot, reused every numFramesInFlight frames
+struct FrameInFlight {
+   VkSemaphore imageAvailableSemaphore;
+   // signaled once the GPU executed the frame's commands, created signaled
+   VkFence inFlightFence;
+   // the PresentWaiter job waiting on the fence (without present wait), it's finished before the fence is reset
+   u64 presentWaitJob;
+};
+
+struct PresentWaiter;
+
 struct VulkanContext {
    VkInstance instance;
-	VkSurfaceKHR windowSurface;
-	VkPhysicalDevice physicalDevice;
-	VkDevice device;
-	VkQueue graphicsQueue;
-	VkQueue presentQueue;
-	// VkSemaphore imageAvailableSemaphore;
-	// VkSemaphore renderingFinishedSemaphore;
-	VkSwapchainKHR swapChain;
-	std::vector<VkImage> swapChainImages;
-	VkCommandPool commandPool;
+   VkSurfaceKHR windowSurface;
+   VkPhysicalDevice physicalDevice;
+   VkDevice device;
+   QueueFamilies queueFamilies;
+   VkQueue graphicsQueue;
+   VkQueue presentQueue;
+   VkQueue computeQueue;
+   VkQueue transferQueue;
+   GpuMemory memory;
+   UploadQueue uploads;
+   VkSwapchainKHR swapChain;
+   VkSurfaceFormatKHR swapChainFormat;
+   VkExtent2D swapChainExtent;
+   VkPresentModeKHR presentMode;
+   platform::PresentPolicy presentPolicy;
+   std::vector<VkImage> swapChainImages;
+   // indexed by image: an image's present waits on it, so it's free again once the image is acquired again
+   std::vector<VkSemaphore> renderingFinishedSemaphores;
+   // WindowSurfaceState::NumResizes the swapchain extent was taken at
+   u32 appliedNumResizes;
+   u32 swapChainImageIndex;
+   b8 isSwapChainOutOfDate;
+   b8 isSwapChainSuboptimal;
+   VkCommandPool commandPool;
+   // indexed by frame in flight, like framesInFlight
    std::vector<VkCommandBuffer> presentCommandBuffers;
+   FrameInFlight framesInFlight[MAX_FRAMES_IN_FLIGHT];
+   u32 numFramesInFlight;
+   u32 frameIndex;
+   // VK_KHR_present_wait, null if the device lacks it: frames are reported to the LatencyProbe once presented,
+   // otherwise once their fence signals
+   PFN_vkWaitForPresentKHR waitForPresent;
+   // the id given to the latest present, ids only grow, also across swapchains
+   u64 lastPresentId;
+   // null while the engine library isn't loaded, see StartPresentWaiter
+   PresentWaiter* presentWaiter;
 };
 
 auto CreateVulkanInstance(const char** requiredExtensions, u32 requiredExtensionsCount) -> VkInstance;
@@ -61,4 +122,18 @@ private:
 
 auto PrintPhysicalDevice(const PhysicalDevice&) -> void;
 
+// VK_KHR_swapchain and the other extensions CreateVulkanDevice enables, logs the first one missing
+auto HasRequiredDeviceExtensions(VkPhysicalDevice) -> b8;
+// the upload queue hands its copies over to graphics with a timeline semaphore (core in Vulkan 1.2)
+auto HasTimelineSemaphores(VkPhysicalDevice) -> b8;
+// VK_KHR_present_id and VK_KHR_present_wait, optional, they let the latency be measured at presentation
+auto HasPresentWait(VkPhysicalDevice) -> b8;
+// nullopt if the device has no graphics family or can't present to the surface
+auto FindQueueFamilies(VkPhysicalDevice, VkSurfaceKHR) -> std::optional<QueueFamilies>;
+// creates context.device with the given features, timeline semaphores and VK_KHR_swapchain (present wait if supported),
+// one queue per distinct family, context.instance, windowSurface and physicalDevice must be set
+auto CreateVulkanDevice(VulkanContext& context, const VkPhysicalDeviceFeatures& enabledFeatures) -> b8;
+// destroys everything that was created (DestroySwapchain and DestroyUploadQueue included), in reverse order, and resets the context
+auto DestroyVulkanContext(VulkanContext& context) -> void;
+
 } // namespace dei
\ No newline at end of file
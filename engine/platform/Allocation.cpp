@@ -0,0 +1,138 @@
+#include "dei_platform/Allocation.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(DEI_LINUX)
+#include <execinfo.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using dei::platform::AllocationGuardMode;
+using dei::platform::AllocationTag;
+
+constexpr u32 GUARD_MAX_LOGGED = 16;
+constexpr int GUARD_BACKTRACE_DEPTH = 32;
+
+// zero initialized at compile time, usable from operator new before any static constructor ran
+std::atomic<u64> numAllocations[dei::platform::ALLOCATION_TAG_COUNT];
+std::atomic<u64> numFrees[dei::platform::ALLOCATION_TAG_COUNT];
+std::atomic<u64> numBytes[dei::platform::ALLOCATION_TAG_COUNT];
+std::atomic<u32> guardMode{static_cast<u32>(AllocationGuardMode::OFF)};
+std::atomic<u64> numGuardViolations{0};
+
+thread_local AllocationTag currentTag = AllocationTag::UNTAGGED;
+thread_local u32 guardDepth = 0;
+thread_local b8 isReportingViolation = false;
+
+auto ReportGuardViolation(size_t numBytesRequested) -> void {
+    auto mode = static_cast<AllocationGuardMode>(guardMode.load(std::memory_order_relaxed));
+    auto violationIndex = numGuardViolations.fetch_add(1, std::memory_order_relaxed);
+    if (mode == AllocationGuardMode::LOG && violationIndex >= GUARD_MAX_LOGGED) {
+        return;
+    }
+    // backtrace() may allocate on its first call
+    isReportingViolation = true;
+    fprintf(stderr, "AllocationGuard: %zu bytes allocated in a guarded scope (tag %s)\n",
+        numBytesRequested, dei::platform::AllocationTagToStr(currentTag));
+#if defined(DEI_LINUX)
+    void* frames[GUARD_BACKTRACE_DEPTH];
+    auto numFrames = backtrace(frames, GUARD_BACKTRACE_DEPTH);
+    backtrace_symbols_fd(frames, numFrames, STDERR_FILENO);
+#endif
+    isReportingViolation = false;
+    if (mode == AllocationGuardMode::ABORT) {
+        std::abort();
+    }
+}
+
+} // namespace ::
+
+namespace dei::platform {
+
+auto AllocationOnNew(size_t numBytesRequested) -> AllocationTag {
+    auto tag = static_cast<u32>(currentTag);
+    numAllocations[tag].fetch_add(1, std::memory_order_relaxed);
+    numBytes[tag].fetch_add(numBytesRequested, std::memory_order_relaxed);
+    if (guardDepth > 0 && !isReportingViolation
+        && guardMode.load(std::memory_order_relaxed) != static_cast<u32>(AllocationGuardMode::OFF)) {
+        ::ReportGuardViolation(numBytesRequested);
+    }
+    return currentTag;
+}
+
+auto AllocationOnDelete(AllocationTag tag) -> void {
+    numFrees[static_cast<u32>(tag)].fetch_add(1, std::memory_order_relaxed);
+}
+
+auto AllocationQuery(AllocationTag tag) -> AllocationStats {
+    auto index = static_cast<u32>(tag);
+    auto stats = AllocationStats{};
+    stats.NumAllocations = numAllocations[index].load(std::memory_order_relaxed);
+    stats.NumFrees = numFrees[index].load(std::memory_order_relaxed);
+    stats.NumBytes = numBytes[index].load(std::memory_order_relaxed);
+    return stats;
+}
+
+auto AllocationGetTotalCount() -> u64 {
+    u64 total = 0;
+    for (const auto& count : numAllocations) {
+        total += count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+auto PrintAllocationStats() -> void {
+    printf("Allocations:\n");
+    for (u32 tag = 0; tag < ALLOCATION_TAG_COUNT; ++tag) {
+        auto stats = AllocationQuery(static_cast<AllocationTag>(tag));
+        printf("%12s: allocations=%lu frees=%lu bytes=%lu\n", AllocationTagToStr(static_cast<AllocationTag>(tag)),
+            stats.NumAllocations, stats.NumFrees, stats.NumBytes);
+    }
+    auto numViolations = AllocationGuardGetViolationCount();
+    if (numViolations > 0) {
+        printf("Allocations in guarded scopes: %lu\n", numViolations);
+    }
+}
+
+auto AllocationSetTag(AllocationTag tag) -> AllocationTag {
+    auto previous = currentTag;
+    currentTag = tag;
+    return previous;
+}
+
+auto AllocationGuardSetMode(AllocationGuardMode mode) -> void {
+    guardMode.store(static_cast<u32>(mode), std::memory_order_relaxed);
+}
+
+auto AllocationGuardModeFromEnvironment() -> AllocationGuardMode {
+    const auto* value = std::getenv("DEI_ALLOCATION_GUARD");
+    if (value == nullptr) {
+        return AllocationGuardMode::OFF;
+    }
+    if (std::strcmp(value, "log") == 0) {
+        return AllocationGuardMode::LOG;
+    }
+    if (std::strcmp(value, "abort") == 0) {
+        return AllocationGuardMode::ABORT;
+    }
+    return AllocationGuardMode::OFF;
+}
+
+auto AllocationGuardGetViolationCount() -> u64 {
+    return numGuardViolations.load(std::memory_order_relaxed);
+}
+
+AllocationGuardScope::AllocationGuardScope(b8 isActive) : _isActive(isActive) {
+    guardDepth += _isActive;
+}
+
+AllocationGuardScope::~AllocationGuardScope() {
+    guardDepth -= _isActive;
+}
+
+}
@@ -0,0 +1,123 @@
+#include "dei_platform/FlightRecorder.hpp"
+#include "dei_platform/Allocation.hpp"
+#include "dei_platform/Util.hpp"
+#include "dei_platform/Log.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+using dei::platform::FlightRecorder;
+using dei::platform::FLIGHT_RECORDER_CAPACITY;
+using dei::platform::FramePhase;
+
+auto WriteSnapshot(const FlightRecorder& recorder) -> void {
+    auto numFrames = recorder.SnapshotNumFrames;
+    auto numRecords = std::min<u64>(numFrames, FLIGHT_RECORDER_CAPACITY);
+    auto firstFrame = numFrames - numRecords;
+    const auto& hitch = recorder.Snapshot[(numFrames - 1) % FLIGHT_RECORDER_CAPACITY];
+    auto hitchMs = static_cast<f64>(hitch.PhaseMs[static_cast<u32>(FramePhase::FRAME_TOTAL)]);
+
+    auto filepath = dei::platform::StringJoin(recorder.DumpDirectory, "/dei_hitch_", recorder.SnapshotDumpIndex,
+        "_frame", hitch.FrameIndex, ".json");
+    auto* file = std::fopen(filepath.c_str(), "w");
+    if (file == nullptr) {
+        DEI_LOG_WARN("FlightRecorder: can't open %s\n", filepath.c_str());
+        return;
+    }
+    std::fprintf(file, "{\"budget_ms\":%.3f,\"hitch_frame\":%lu,\"hitch_ms\":%.3f,\"frames\":[\n",
+        static_cast<f64>(recorder.BudgetMs), hitch.FrameIndex, hitchMs);
+    for (auto frame = firstFrame; frame < numFrames; ++frame) {
+        const auto& record = recorder.Snapshot[frame % FLIGHT_RECORDER_CAPACITY];
+        std::fprintf(file, "{\"frame\":%lu,\"begin_ns\":%ld,\"phases_ms\":{", record.FrameIndex, record.FrameBeginNanosec);
+        for (u32 phase = 0; phase < dei::platform::FRAME_PHASE_COUNT; ++phase) {
+            std::fprintf(file, "%s\"%s\":%.3f", phase == 0 ? "" : ",",
+                dei::platform::FramePhaseToStr(static_cast<FramePhase>(phase)), static_cast<f64>(record.PhaseMs[phase]));
+        }
+        std::fprintf(file,
+            "},\"events\":%u,\"simulation_steps\":%u,\"allocations\":%u,"
+            "\"reload_version\":%u,\"reload_failure\":%d,\"reload_answer\":%d}%s\n",
+            record.NumEvents, record.NumSimulationSteps, record.NumAllocations,
+            record.HotReloadVersion, record.HotReloadFailure, record.HotReloadAnswer,
+            frame + 1 < numFrames ? "," : "");
+    }
+    std::fputs("]}\n", file);
+    std::fclose(file);
+    DEI_LOG_INFO("FlightRecorder: frame %lu took %.3f ms (budget %.3f ms), last %lu frames written to %s\n",
+        hitch.FrameIndex, hitchMs, static_cast<f64>(recorder.BudgetMs), numRecords, filepath.c_str());
+}
+
+auto WriterLoop(FlightRecorder* recorder) -> void {
+    dei::platform::AllocationSetTag(dei::platform::AllocationTag::PROFILER);
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock{recorder->Mutex};
+            recorder->DumpRequested.wait(lock, [recorder]() {
+                return recorder->IsDumpPending.load(std::memory_order_acquire)
+                    || !recorder->IsRunning.load(std::memory_order_acquire);
+            });
+        }
+        if (!recorder->IsDumpPending.load(std::memory_order_acquire)) {
+            return;
+        }
+        ::WriteSnapshot(*recorder);
+        recorder->IsDumpPending.store(false, std::memory_order_release);
+    }
+}
+
+} // namespace ::
+
+namespace dei::platform {
+
+auto FlightRecorderConfigure(FlightRecorder& recorder, const char* dumpDirectory, f32 budgetMs, f64 cooldownSec) -> void {
+    recorder.DumpDirectory = dumpDirectory;
+    recorder.BudgetMs = budgetMs;
+    recorder.CooldownNanosec = static_cast<i64>(cooldownSec * 1e9);
+    recorder.LastDumpNanosec = 0;
+    if (!recorder.IsRunning.exchange(true)) {
+        recorder.Writer = std::thread{&::WriterLoop, &recorder};
+    }
+}
+
+auto FlightRecorderStop(FlightRecorder& recorder) -> void {
+    {
+        std::lock_guard<std::mutex> lock{recorder.Mutex};
+        if (recorder.IsRunning.exchange(false) == false) {
+            return;
+        }
+    }
+    recorder.DumpRequested.notify_one();
+    recorder.Writer.join();
+    if (recorder.NumSkippedDumps > 0) {
+        DEI_LOG_WARN("FlightRecorder: %u hitches not written, the previous dump was still being written\n",
+            recorder.NumSkippedDumps);
+    }
+}
+
+auto FlightRecorderDump(FlightRecorder& recorder) -> b8 {
+    auto now = GetMonotonicNanosec();
+    if (recorder.NumDumps > 0 && now - recorder.LastDumpNanosec < recorder.CooldownNanosec) {
+        return false;
+    }
+    if (!recorder.IsRunning.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    // the writer is still on the previous snapshot, don't wait for it
+    if (recorder.IsDumpPending.load(std::memory_order_acquire)) {
+        ++recorder.NumSkippedDumps;
+        return false;
+    }
+    recorder.LastDumpNanosec = now;
+    std::copy(std::begin(recorder.Records), std::end(recorder.Records), std::begin(recorder.Snapshot));
+    recorder.SnapshotNumFrames = recorder.NumFrames;
+    recorder.SnapshotDumpIndex = recorder.NumDumps++;
+    {
+        std::lock_guard<std::mutex> lock{recorder.Mutex};
+        recorder.IsDumpPending.store(true, std::memory_order_release);
+    }
+    recorder.DumpRequested.notify_one();
+    return true;
+}
+
+}
@@ -0,0 +1,66 @@
+#include "dei_platform/Format.hpp"
+
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+constexpr u64 POWERS_OF_10[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000,
+};
+constexpr u32 MAX_PRECISION = 9;
+constexpr f64 MAX_FIXED_VALUE = 1e18; // the integer part fits u64
+
+auto PutU64(dei::platform::FormatOutput& output, u64 value) -> void {
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    dei::platform::FormatPut(output, buffer, static_cast<size_t>(result.ptr - buffer));
+}
+
+} // namespace ::
+
+namespace dei::platform {
+
+// std::to_chars for floating point isn't available in every standard library the engine is built with,
+// the fixed notation is done with two integers instead
+auto FormatPutF64(FormatOutput& output, f64 value, u32 precision) -> void {
+    if (std::isnan(value)) {
+        FormatPut(output, "nan", 3);
+        return;
+    }
+    if (std::signbit(value)) {
+        FormatPut(output, '-');
+        value = -value;
+    }
+    if (std::isinf(value)) {
+        FormatPut(output, "inf", 3);
+        return;
+    }
+    precision = std::min(precision, MAX_PRECISION);
+    if (value >= MAX_FIXED_VALUE) {
+        char buffer[32];
+        auto numBytes = std::snprintf(buffer, sizeof(buffer), "%.*e", static_cast<int>(precision), value);
+        FormatPut(output, buffer, static_cast<size_t>(numBytes));
+        return;
+    }
+    auto scale = POWERS_OF_10[precision];
+    auto integer = static_cast<u64>(value);
+    auto fraction = static_cast<u64>((value - static_cast<f64>(integer)) * static_cast<f64>(scale) + 0.5);
+    if (fraction >= scale) {
+        ++integer;
+        fraction -= scale;
+    }
+    ::PutU64(output, integer);
+    if (precision == 0) {
+        return;
+    }
+    FormatPut(output, '.');
+    char digits[MAX_PRECISION];
+    for (auto i = precision; i > 0; --i) {
+        digits[i - 1] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    FormatPut(output, digits, precision);
+}
+
+}
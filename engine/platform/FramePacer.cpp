@@ -0,0 +1,161 @@
+#include "dei_platform/FramePacer.hpp"
+#include "dei_platform/Time.hpp"
+#include "dei_platform/Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(DEI_LINUX)
+#include <time.h>
+#include <errno.h>
+#endif
+
+namespace {
+
+constexpr i64 NANOSEC_IN_SEC = 1000000000LL;
+constexpr i64 SPIN_THRESHOLD_MIN_NANOSEC = 50000LL;
+constexpr i64 SPIN_THRESHOLD_MAX_NANOSEC = 2000000LL;
+constexpr int CALIBRATION_ITERATIONS = 16;
+constexpr i64 CALIBRATION_SLEEP_NANOSEC = 100000LL;
+
+inline auto CpuRelax() -> void {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+inline auto PeriodFromRate(f64 targetRateHz) -> i64 {
+    if (targetRateHz <= 0.0) {
+        return 0;
+    }
+    return static_cast<i64>(static_cast<f64>(NANOSEC_IN_SEC) / targetRateHz);
+}
+
+// coarse OS sleep until the absolute monotonic time
+auto SleepUntil(i64 deadlineNanosec) -> void {
+#if defined(DEI_LINUX)
+    timespec deadline;
+    deadline.tv_sec = static_cast<time_t>(deadlineNanosec / NANOSEC_IN_SEC);
+    deadline.tv_nsec = static_cast<long>(deadlineNanosec % NANOSEC_IN_SEC);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+        // interrupted by a signal, the deadline is absolute so just retry
+    }
+#else
+    auto remainingNanosec = deadlineNanosec - dei::platform::GetMonotonicNanosec();
+    if (remainingNanosec >= 1000000LL) {
+        dei::platform::ThreadSleepMs(static_cast<u32>(remainingNanosec / 1000000LL));
+    }
+#endif
+}
+
+inline auto SpinUntil(i64 deadlineNanosec) -> i64 {
+    auto now = dei::platform::GetMonotonicNanosec();
+    while (now < deadlineNanosec) {
+        CpuRelax();
+        now = dei::platform::GetMonotonicNanosec();
+    }
+    return now;
+}
+
+// measures how late the OS wakes us up from a short absolute sleep
+auto CalibrateSpinThreshold() -> i64 {
+    i64 worstOversleep = 0;
+    for (int i = 0; i < CALIBRATION_ITERATIONS; ++i) {
+        auto target = dei::platform::GetMonotonicNanosec() + CALIBRATION_SLEEP_NANOSEC;
+        SleepUntil(target);
+        worstOversleep = std::max(worstOversleep, dei::platform::GetMonotonicNanosec() - target);
+    }
+    return std::clamp(worstOversleep + worstOversleep / 2,
+        SPIN_THRESHOLD_MIN_NANOSEC, SPIN_THRESHOLD_MAX_NANOSEC);
+}
+
+auto AdaptSpinThreshold(dei::platform::FramePacer& pacer, i64 oversleepNanosec) -> void {
+    if (oversleepNanosec > pacer.SpinThresholdNanosec) {
+        // woke up after the deadline, react immediately
+        pacer.SpinThresholdNanosec = oversleepNanosec + oversleepNanosec / 4;
+    } else {
+        // slowly give back the CPU time when the scheduler behaves
+        pacer.SpinThresholdNanosec -= (pacer.SpinThresholdNanosec - 2 * oversleepNanosec) / 256;
+    }
+    pacer.SpinThresholdNanosec = std::clamp(pacer.SpinThresholdNanosec,
+        SPIN_THRESHOLD_MIN_NANOSEC, SPIN_THRESHOLD_MAX_NANOSEC);
+}
+
+auto RecordJitter(dei::platform::FramePacer& pacer, i64 jitterNanosec) -> void {
+    // Welford's online mean/variance
+    auto jitter = static_cast<f64>(jitterNanosec);
+    ++pacer.NumJitterSamples;
+    auto delta = jitter - pacer.JitterMeanNanosec;
+    pacer.JitterMeanNanosec += delta / static_cast<f64>(pacer.NumJitterSamples);
+    pacer.JitterM2Nanosec += delta * (jitter - pacer.JitterMeanNanosec);
+    pacer.JitterMaxNanosec = std::max(pacer.JitterMaxNanosec, jitter);
+}
+
+} // namespace ::
+
+namespace dei::platform {
+
+auto CreateFramePacer(f64 targetRateHz) -> FramePacer {
+    auto pacer = FramePacer{};
+    pacer.PeriodNanosec = ::PeriodFromRate(targetRateHz);
+    pacer.SpinThresholdNanosec = ::CalibrateSpinThreshold();
+    pacer.NextDeadlineNanosec = GetMonotonicNanosec() + pacer.PeriodNanosec;
+    return pacer;
+}
+
+auto FramePacerSetTargetRate(FramePacer& pacer, f64 targetRateHz) -> void {
+    auto newPeriod = ::PeriodFromRate(targetRateHz);
+    pacer.NextDeadlineNanosec += newPeriod - pacer.PeriodNanosec;
+    pacer.PeriodNanosec = newPeriod;
+}
+
+auto FramePacerWait(FramePacer& pacer) -> b8 {
+    DEI_PROFILE_SCOPE("FramePacerWait");
+    ++pacer.NumFrames;
+    if (pacer.PeriodNanosec <= 0) {
+        return true;
+    }
+    auto deadline = pacer.NextDeadlineNanosec;
+    auto now = GetMonotonicNanosec();
+    if (now >= deadline) {
+        ++pacer.NumMissedDeadlines;
+        // re-anchor instead of bursting frames to catch up
+        pacer.NextDeadlineNanosec = now + pacer.PeriodNanosec;
+        return false;
+    }
+    auto sleepTarget = deadline - pacer.SpinThresholdNanosec;
+    if (now < sleepTarget) {
+        ::SleepUntil(sleepTarget);
+        ::AdaptSpinThreshold(pacer, GetMonotonicNanosec() - sleepTarget);
+    }
+    auto wokeUp = ::SpinUntil(deadline);
+    ::RecordJitter(pacer, wokeUp - deadline);
+    pacer.NextDeadlineNanosec = deadline + pacer.PeriodNanosec;
+    return true;
+}
+
+auto FramePacerGetStats(const FramePacer& pacer) -> FramePacerStats {
+    auto stats = FramePacerStats{};
+    stats.NumFrames = pacer.NumFrames;
+    stats.NumMissedDeadlines = pacer.NumMissedDeadlines;
+    stats.JitterMeanMicrosec = pacer.JitterMeanNanosec / 1000.0;
+    stats.JitterMaxMicrosec = pacer.JitterMaxNanosec / 1000.0;
+    stats.JitterStdDevMicrosec = pacer.NumJitterSamples > 1
+        ? std::sqrt(pacer.JitterM2Nanosec / static_cast<f64>(pacer.NumJitterSamples - 1)) / 1000.0
+        : 0.0;
+    stats.SpinThresholdMicrosec = static_cast<f64>(pacer.SpinThresholdNanosec) / 1000.0;
+    return stats;
+}
+
+auto FramePacerResetStats(FramePacer& pacer) -> void {
+    pacer.NumFrames = 0;
+    pacer.NumMissedDeadlines = 0;
+    pacer.NumJitterSamples = 0;
+    pacer.JitterMeanNanosec = 0.0;
+    pacer.JitterM2Nanosec = 0.0;
+    pacer.JitterMaxNanosec = 0.0;
+}
+
+}
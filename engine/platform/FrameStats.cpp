@@ -0,0 +1,54 @@
+#include "dei_platform/FrameStats.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+inline auto PercentileIndex(u32 numSamples, u32 percentile) -> u32 {
+    return std::min(numSamples - 1, (numSamples * percentile) / 100);
+}
+
+} // namespace ::
+
+namespace dei::platform {
+
+auto FrameStatsQuery(const FrameStats& stats, FramePhase phase) -> FramePhaseSummary {
+    const auto& ring = stats.Phases[static_cast<u32>(phase)];
+    auto summary = FramePhaseSummary{};
+    summary.NumSamples = ring.NumSamples;
+    if (ring.NumSamples == 0) {
+        return summary;
+    }
+    summary.LastMs = FrameStatsLastMs(stats, phase);
+
+    // copy on stack, the ring keeps being written in arrival order
+    f32 sorted[FRAME_STATS_WINDOW];
+    std::copy(ring.SamplesMs, ring.SamplesMs + ring.NumSamples, sorted);
+    auto* end = sorted + ring.NumSamples;
+    auto p50 = sorted + ::PercentileIndex(ring.NumSamples, 50);
+    auto p95 = sorted + ::PercentileIndex(ring.NumSamples, 95);
+    auto p99 = sorted + ::PercentileIndex(ring.NumSamples, 99);
+    std::nth_element(sorted, p50, end);
+    std::nth_element(p50, p95, end);
+    std::nth_element(p95, p99, end);
+    summary.P50Ms = *p50;
+    summary.P95Ms = *p95;
+    summary.P99Ms = *p99;
+    summary.MaxMs = *std::max_element(p99, end);
+    return summary;
+}
+
+auto PrintFrameStats(const FrameStats& stats) -> void {
+    printf("%-16s %9s %9s %9s %9s %9s\n", "phase (ms)", "last", "p50", "p95", "p99", "max");
+    for (u32 i = 0; i < FRAME_PHASE_COUNT; ++i) {
+        auto phase = static_cast<FramePhase>(i);
+        auto summary = FrameStatsQuery(stats, phase);
+        printf("%-16s %9.3f %9.3f %9.3f %9.3f %9.3f\n", FramePhaseToStr(phase),
+            static_cast<f64>(summary.LastMs), static_cast<f64>(summary.P50Ms),
+            static_cast<f64>(summary.P95Ms), static_cast<f64>(summary.P99Ms),
+            static_cast<f64>(summary.MaxMs));
+    }
+}
+
+}
@@ -0,0 +1,43 @@
+#include "dei_platform/IdlePolicy.hpp"
+
+#include <algorithm>
+
+namespace dei::platform {
+
+auto CreateIdlePolicy(IdleBehavior behavior, f64 activeRateHz, f64 backgroundRateHz) -> IdlePolicy {
+    auto policy = IdlePolicy{};
+    policy.Behavior = behavior;
+    policy.ActiveRateHz = activeRateHz;
+    policy.BackgroundRateHz = activeRateHz > 0.0 ? std::min(activeRateHz, backgroundRateHz) : backgroundRateHz;
+    policy.IdleWaitSec = 0.25;
+    policy.IsRedrawRequested = true;
+    return policy;
+}
+
+auto IdlePolicyUpdate(IdlePolicy& policy, const WindowHandle& window) -> IdleMode {
+    if (policy.Behavior == IdleBehavior::ALWAYS_RENDER) {
+        return IdleMode::ACTIVE;
+    }
+    if (WindowIsVisible(window) == false || WindowGetSizeMode(window) == WindowSizeMode::MINIMIZED) {
+        return IdleMode::HIDDEN;
+    }
+    auto eventCount = WindowGetEventCount(window);
+    if (policy.Behavior == IdleBehavior::REDRAW_ON_DEMAND) {
+        if (eventCount == policy.LastEventCount && policy.IsRedrawRequested == false) {
+            return IdleMode::WAITING_FOR_EVENTS;
+        }
+        policy.IsRedrawRequested = false;
+    }
+    policy.LastEventCount = eventCount;
+    return WindowIsFocused(window) ? IdleMode::ACTIVE : IdleMode::BACKGROUND;
+}
+
+auto IdlePolicyRequestRedraw(IdlePolicy& policy) -> void {
+    policy.IsRedrawRequested = true;
+}
+
+auto IdlePolicyTargetRate(const IdlePolicy& policy, IdleMode mode) -> f64 {
+    return mode == IdleMode::BACKGROUND ? policy.BackgroundRateHz : policy.ActiveRateHz;
+}
+
+}
@@ -0,0 +1,111 @@
+#include "dei_platform/InputRecording.hpp"
+#include "dei_platform/Log.hpp"
+
+namespace {
+
+using dei::platform::input::InputRecord;
+using dei::platform::input::InputRecording;
+
+// stdio buffers the writes, the callbacks don't wait for the disk; the data may still fail to reach it
+// (disk full), the recording is closed then, so it ends at a record boundary
+auto WriteRecord(InputRecording& recording, const InputRecord& record) -> void {
+    if (recording.File == nullptr || recording.IsReplaying) {
+        return;
+    }
+    if (std::fwrite(&record, sizeof(record), 1, recording.File) != 1) {
+        DEI_LOG_ERROR("InputRecording: write failed, the recording is truncated after %lu records\n",
+            recording.NumRecords);
+        std::fclose(recording.File);
+        recording = InputRecording{};
+        return;
+    }
+    ++recording.NumRecords;
+}
+
+} // namespace ::
+
+namespace dei::platform::input {
+
+auto InputRecordingOpenWrite(InputRecording& recording, const char* filepath) -> b8 {
+    InputRecordingClose(recording);
+    auto* file = std::fopen(filepath, "wb");
+    if (file == nullptr) {
+        DEI_LOG_WARN("InputRecording: can't open %s\n", filepath);
+        return false;
+    }
+    auto header = InputRecordingHeader{ INPUT_RECORDING_MAGIC, INPUT_RECORDING_VERSION, sizeof(InputRecord), 0 };
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        DEI_LOG_WARN("InputRecording: can't write %s\n", filepath);
+        std::fclose(file);
+        return false;
+    }
+    recording.File = file;
+    recording.IsReplaying = false;
+    return true;
+}
+
+auto InputRecordingOpenRead(InputRecording& recording, const char* filepath) -> b8 {
+    InputRecordingClose(recording);
+    auto* file = std::fopen(filepath, "rb");
+    if (file == nullptr) {
+        DEI_LOG_WARN("InputRecording: can't open %s\n", filepath);
+        return false;
+    }
+    auto header = InputRecordingHeader{};
+    if (std::fread(&header, sizeof(header), 1, file) != 1
+        || header.Magic != INPUT_RECORDING_MAGIC
+        || header.Version != INPUT_RECORDING_VERSION
+        || header.RecordSize != sizeof(InputRecord)) {
+        DEI_LOG_WARN("InputRecording: %s is not a compatible input recording\n", filepath);
+        std::fclose(file);
+        return false;
+    }
+    recording.File = file;
+    recording.IsReplaying = true;
+    InputRecordingReadNext(recording);
+    return true;
+}
+
+auto InputRecordingClose(InputRecording& recording) -> void {
+    // fclose flushes what stdio still buffers
+    if (recording.File != nullptr && std::fclose(recording.File) != 0 && !recording.IsReplaying) {
+        DEI_LOG_ERROR("InputRecording: flushing failed, the recording is truncated (%lu records written)\n",
+            recording.NumRecords);
+    }
+    recording = InputRecording{};
+}
+
+auto InputRecordingIsOpen(const InputRecording& recording) -> b8 {
+    return recording.File != nullptr;
+}
+
+auto InputRecordingWrite(InputRecording& recording, u64 frameIndex, const InputEvent& event) -> void {
+    ::WriteRecord(recording, InputRecord{ frameIndex, event });
+}
+
+auto InputRecordingWriteFrame(InputRecording& recording, u64 frameIndex, i64 frameNanosec) -> void {
+    auto event = InputEvent{};
+    event.TimestampNanosec = frameNanosec;
+    event.Type = InputEventType::FRAME_BEGIN;
+    ::WriteRecord(recording, InputRecord{ frameIndex, event });
+}
+
+auto InputRecordingReadNext(InputRecording& recording) -> b8 {
+    recording.HasNextRecord = false;
+    if (recording.File == nullptr || !recording.IsReplaying) {
+        return false;
+    }
+    auto numBytesRead = std::fread(&recording.NextRecord, 1, sizeof(InputRecord), recording.File);
+    if (numBytesRead != sizeof(InputRecord)) {
+        if (numBytesRead != 0 || std::ferror(recording.File)) {
+            DEI_LOG_WARN("InputRecording: the recording is truncated after %lu records, replaying them only\n",
+                recording.NumRecords);
+        }
+        return false;
+    }
+    recording.HasNextRecord = true;
+    ++recording.NumRecords;
+    return true;
+}
+
+}
@@ -0,0 +1,216 @@
+#include "dei_platform/Log.hpp"
+#include "dei_platform/Allocation.hpp"
+#include "dei_platform/Time.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using dei::platform::LogLevel;
+using dei::platform::LogFormatFn;
+
+constexpr u32 THREAD_RING_CAPACITY = 1u << 16u; // bytes, power of 2
+constexpr u32 THREAD_RING_MASK = THREAD_RING_CAPACITY - 1;
+constexpr u32 MAX_RECORD_BYTES = THREAD_RING_CAPACITY / 4;
+constexpr u32 WRITER_PERIOD_MS = 5;
+
+struct RecordHeader {
+    u32 NumBytes; // header and payload, a multiple of 8
+    b8 IsPadding; // the rest of the ring up to its end is unused
+    LogLevel Level;
+    i64 TimestampNanosec;
+    const char* Format;
+    LogFormatFn FormatFn;
+};
+static_assert(sizeof(RecordHeader) % 8 == 0);
+
+// single producer (owning thread), single consumer (writer thread or whoever holds the mutex),
+// Head and Tail count bytes
+struct ThreadRing {
+    alignas(64) std::atomic<u32> Head{0};
+    alignas(64) std::atomic<u32> Tail{0};
+    std::atomic<u64> NumDropped{0};
+    u32 PendingHead{0};
+    alignas(8) u8 Bytes[THREAD_RING_CAPACITY];
+};
+
+struct LogState {
+    std::atomic<b8> IsRunning{false};
+    std::mutex Mutex; // guards everything below, never taken on the record fast path while running
+    std::vector<ThreadRing*> ThreadRings;
+    std::thread Writer;
+};
+
+// never destroyed: lives as long as libdeiPlatform, which outlives engine reloads
+auto GetState() -> LogState& {
+    static auto* state = new LogState{};
+    return *state;
+}
+
+thread_local ThreadRing* threadRing = nullptr;
+
+auto RegisterThreadRing() -> ThreadRing* {
+    auto& state = GetState();
+    auto* ring = new ThreadRing{};
+    std::lock_guard<std::mutex> lock{state.Mutex};
+    state.ThreadRings.push_back(ring);
+    return ring;
+}
+
+inline auto AlignRecordSize(u32 numBytes) -> u32 {
+    return (numBytes + 7u) & ~7u;
+}
+
+inline auto HeaderAt(ThreadRing& ring, u32 position) -> RecordHeader* {
+    return reinterpret_cast<RecordHeader*>(ring.Bytes + (position & THREAD_RING_MASK));
+}
+
+// skips padding, returns nullptr if the ring is empty
+auto PeekRecord(ThreadRing& ring) -> RecordHeader* {
+    auto tail = ring.Tail.load(std::memory_order_relaxed);
+    auto head = ring.Head.load(std::memory_order_acquire);
+    if (tail == head) {
+        return nullptr;
+    }
+    auto* header = ::HeaderAt(ring, tail);
+    if (header->IsPadding) {
+        tail += header->NumBytes;
+        ring.Tail.store(tail, std::memory_order_release);
+        if (tail == head) {
+            return nullptr;
+        }
+        header = ::HeaderAt(ring, tail);
+    }
+    return header;
+}
+
+auto WriteRecord(const RecordHeader& header) -> void {
+    auto* file = header.Level >= LogLevel::WARN ? stderr : stdout;
+    if (file == stderr) {
+        // keeps the order of the records across the two streams
+        std::fflush(stdout);
+    }
+    if (header.Level == LogLevel::WARN) {
+        std::fputs("warning: ", file);
+    } else if (header.Level == LogLevel::ERROR) {
+        std::fputs("error: ", file);
+    }
+    const auto* payload = reinterpret_cast<const u8*>(&header + 1);
+    header.FormatFn(file, header.Format, payload);
+}
+
+// must be called with state.Mutex locked, writes the records of all threads in timestamp order
+auto DrainThreadRings(LogState& state) -> void {
+    u64 numWritten = 0;
+    while (true) {
+        ThreadRing* oldestRing = nullptr;
+        RecordHeader* oldest = nullptr;
+        for (auto* ring : state.ThreadRings) {
+            auto* header = ::PeekRecord(*ring);
+            if (header != nullptr && (oldest == nullptr || header->TimestampNanosec < oldest->TimestampNanosec)) {
+                oldest = header;
+                oldestRing = ring;
+            }
+        }
+        if (oldest == nullptr) {
+            break;
+        }
+        ::WriteRecord(*oldest);
+        oldestRing->Tail.fetch_add(oldest->NumBytes, std::memory_order_release);
+        ++numWritten;
+    }
+    for (auto* ring : state.ThreadRings) {
+        if (auto numDropped = ring->NumDropped.exchange(0, std::memory_order_relaxed); numDropped > 0) {
+            std::fflush(stdout);
+            std::fprintf(stderr, "warning: Log: dropped %lu records, the thread's ring was full\n", numDropped);
+        }
+    }
+    if (numWritten > 0) {
+        std::fflush(stdout);
+    }
+}
+
+auto WriterLoop() -> void {
+    auto& state = GetState();
+    dei::platform::AllocationSetTag(dei::platform::AllocationTag::LOG);
+    while (state.IsRunning.load(std::memory_order_acquire)) {
+        {
+            std::lock_guard<std::mutex> lock{state.Mutex};
+            ::DrainThreadRings(state);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(WRITER_PERIOD_MS));
+    }
+}
+
+} // namespace ::
+
+namespace dei::platform {
+
+auto LogStart() -> void {
+    auto& state = GetState();
+    if (state.IsRunning.exchange(true)) {
+        return;
+    }
+    LogRegisterThread();
+    state.Writer = std::thread{&::WriterLoop};
+}
+
+auto LogStop() -> void {
+    auto& state = GetState();
+    if (state.IsRunning.exchange(false) == false) {
+        return;
+    }
+    state.Writer.join();
+    LogFlush();
+}
+
+auto LogFlush() -> void {
+    auto& state = GetState();
+    std::lock_guard<std::mutex> lock{state.Mutex};
+    ::DrainThreadRings(state);
+}
+
+auto LogRegisterThread() -> void {
+    if (threadRing == nullptr) {
+        threadRing = ::RegisterThreadRing();
+    }
+}
+
+auto LogBeginRecord(LogLevel level, const char* format, LogFormatFn formatFn, u32 numPayloadBytes) -> u8* {
+    LogRegisterThread();
+    auto& ring = *threadRing;
+    auto numBytes = ::AlignRecordSize(static_cast<u32>(sizeof(RecordHeader)) + numPayloadBytes);
+    auto head = ring.Head.load(std::memory_order_relaxed);
+    auto tail = ring.Tail.load(std::memory_order_acquire);
+    // records are contiguous, the end of the ring is skipped if the record doesn't fit there
+    auto numPaddingBytes = THREAD_RING_CAPACITY - (head & THREAD_RING_MASK);
+    if (numPaddingBytes >= numBytes) {
+        numPaddingBytes = 0;
+    }
+    if (numBytes > MAX_RECORD_BYTES || head + numPaddingBytes + numBytes - tail > THREAD_RING_CAPACITY) {
+        ring.NumDropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    if (numPaddingBytes > 0) {
+        auto* padding = ::HeaderAt(ring, head);
+        padding->NumBytes = numPaddingBytes;
+        padding->IsPadding = true;
+        head += numPaddingBytes;
+    }
+    auto* header = ::HeaderAt(ring, head);
+    *header = RecordHeader{ numBytes, false, level, GetMonotonicNanosec(), format, formatFn };
+    ring.PendingHead = head + numBytes;
+    return reinterpret_cast<u8*>(header + 1);
+}
+
+auto LogCommitRecord() -> void {
+    threadRing->Head.store(threadRing->PendingHead, std::memory_order_release);
+    if (GetState().IsRunning.load(std::memory_order_relaxed) == false) {
+        LogFlush();
+    }
+}
+
+}
@@ -0,0 +1,115 @@
+#include "dei_platform/MetricsPage.hpp"
+#include "dei_platform/Util.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(DEI_LINUX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr u32 READ_ATTEMPTS = 64;
+
+} // namespace ::
+
+namespace dei::platform {
+
+auto CreateMetricsPublisher(const char* namePrefix) -> std::optional<MetricsPublisher> {
+#if defined(DEI_LINUX)
+    auto shmName = StringJoin("/", namePrefix, "_", getpid());
+    auto fd = shm_open(shmName.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        printf("Metrics: shm_open(%s) failed\n", shmName.c_str());
+        return std::nullopt;
+    }
+    if (ftruncate(fd, sizeof(MetricsPage)) != 0) {
+        close(fd);
+        shm_unlink(shmName.c_str());
+        return std::nullopt;
+    }
+    auto* memory = mmap(nullptr, sizeof(MetricsPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(shmName.c_str());
+        return std::nullopt;
+    }
+    auto* page = new (memory) MetricsPage{};
+    page->Version = METRICS_PAGE_VERSION;
+    page->ProcessId = static_cast<u32>(getpid());
+    page->SnapshotSize = sizeof(MetricsSnapshot);
+    // readers check the magic last
+    std::atomic_thread_fence(std::memory_order_release);
+    page->Magic = METRICS_PAGE_MAGIC;
+    return MetricsPublisher{page, std::move(shmName)};
+#else
+    (void)namePrefix;
+    return std::nullopt;
+#endif
+}
+
+auto DestroyMetricsPublisher(MetricsPublisher& publisher) -> void {
+    if (publisher.Page == nullptr) {
+        return;
+    }
+#if defined(DEI_LINUX)
+    munmap(publisher.Page, sizeof(MetricsPage));
+    shm_unlink(publisher.Name.c_str());
+#endif
+    publisher.Page = nullptr;
+}
+
+auto MetricsPublish(MetricsPublisher& publisher, const MetricsSnapshot& snapshot) -> void {
+    auto* page = publisher.Page;
+    auto sequence = page->Sequence.load(std::memory_order_relaxed);
+    page->Sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&page->Snapshot, &snapshot, sizeof(MetricsSnapshot));
+    page->Sequence.store(sequence + 2, std::memory_order_release);
+}
+
+auto MetricsPageRead(const MetricsPage& page, MetricsSnapshot& destination) -> b8 {
+    for (u32 attempt = 0; attempt < ::READ_ATTEMPTS; ++attempt) {
+        auto before = page.Sequence.load(std::memory_order_acquire);
+        if (before % 2 != 0) {
+            continue;
+        }
+        std::memcpy(&destination, &page.Snapshot, sizeof(MetricsSnapshot));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (page.Sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+auto GetResidentBytes() -> u64 {
+#if defined(DEI_LINUX)
+    // opened once and re-read with pread, no stdio locks or open/close on the frame thread
+    static const auto statm = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+    static const auto pageBytes = static_cast<u64>(sysconf(_SC_PAGESIZE));
+    if (statm < 0) {
+        return 0;
+    }
+    char text[128];
+    auto numRead = pread(statm, text, sizeof(text) - 1, 0);
+    if (numRead <= 0) {
+        return 0;
+    }
+    text[numRead] = '\0';
+    // "size resident shared text lib data dt" in pages
+    char* end = nullptr;
+    std::strtoull(text, &end, 10);
+    auto residentPages = std::strtoull(end, &end, 10);
+    return static_cast<u64>(residentPages) * pageBytes;
+#else
+    return 0;
+#endif
+}
+
+}
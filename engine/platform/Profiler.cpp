@@ -0,0 +1,196 @@
+#include "dei_platform/Profiler.hpp"
+#include "dei_platform/Allocation.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(DEI_LINUX)
+#include <unistd.h>
+#endif
+
+namespace {
+
+using dei::platform::ProfilerEventType;
+
+constexpr u32 THREAD_BUFFER_CAPACITY = 1u << 16u; // power of 2
+constexpr u32 THREAD_BUFFER_MASK = THREAD_BUFFER_CAPACITY - 1;
+constexpr u32 WRITER_PERIOD_MS = 10;
+
+struct ProfilerEvent {
+    u64 ClockCounter;
+    u32 NameId;
+    ProfilerEventType Type;
+};
+
+// single producer (owning thread), single consumer (writer thread)
+struct ThreadBuffer {
+    alignas(64) std::atomic<u32> Head{0};
+    alignas(64) std::atomic<u32> Tail{0};
+    std::atomic<u64> NumDropped{0};
+    u32 ThreadId{0};
+    ProfilerEvent Events[THREAD_BUFFER_CAPACITY];
+};
+
+struct ProfilerState {
+    std::atomic<b8> IsRunning{false};
+    std::mutex Mutex; // guards everything below, never taken on the emit fast path
+    std::vector<ThreadBuffer*> ThreadBuffers;
+    std::vector<std::string> Names;
+    std::unordered_map<std::string, u32> NameIds;
+    std::thread Writer;
+    std::FILE* TraceFile{nullptr};
+    b8 HasWrittenEvents{false};
+    u64 StartClockCounter{0};
+    f64 CounterToMicrosec{0.0};
+};
+
+// never destroyed: lives as long as libdeiPlatform, which outlives engine reloads
+auto GetState() -> ProfilerState& {
+    static auto* state = new ProfilerState{};
+    return *state;
+}
+
+thread_local ThreadBuffer* threadBuffer = nullptr;
+
+auto RegisterThreadBuffer() -> ThreadBuffer* {
+    auto& state = GetState();
+    auto* buffer = new ThreadBuffer{};
+    std::lock_guard<std::mutex> lock{state.Mutex};
+    buffer->ThreadId = static_cast<u32>(state.ThreadBuffers.size());
+    state.ThreadBuffers.push_back(buffer);
+    return buffer;
+}
+
+auto WriteEscaped(std::FILE* file, const char* text) -> void {
+    for (; *text != '\0'; ++text) {
+        if (*text == '"' || *text == '\\') {
+            std::fputc('\\', file);
+        }
+        std::fputc(*text, file);
+    }
+}
+
+// must be called with state.Mutex locked
+auto DrainThreadBuffers(ProfilerState& state) -> void {
+    int pid = 1;
+#if defined(DEI_LINUX)
+    pid = static_cast<int>(getpid());
+#endif
+    for (auto* buffer : state.ThreadBuffers) {
+        auto tail = buffer->Tail.load(std::memory_order_relaxed);
+        auto head = buffer->Head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            const auto& event = buffer->Events[tail & THREAD_BUFFER_MASK];
+            auto timestampMicrosec = static_cast<f64>(event.ClockCounter - state.StartClockCounter)
+                * state.CounterToMicrosec;
+            std::fputs(state.HasWrittenEvents ? ",\n{\"name\":\"" : "{\"name\":\"", state.TraceFile);
+            ::WriteEscaped(state.TraceFile, state.Names[event.NameId].c_str());
+            std::fprintf(state.TraceFile, "\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u}",
+                event.Type == ProfilerEventType::BEGIN ? 'B' : 'E',
+                timestampMicrosec, pid, buffer->ThreadId);
+            state.HasWrittenEvents = true;
+        }
+        buffer->Tail.store(head, std::memory_order_release);
+    }
+}
+
+auto WriterLoop() -> void {
+    auto& state = GetState();
+    dei::platform::AllocationSetTag(dei::platform::AllocationTag::PROFILER);
+    while (state.IsRunning.load(std::memory_order_acquire)) {
+        {
+            std::lock_guard<std::mutex> lock{state.Mutex};
+            ::DrainThreadBuffers(state);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(WRITER_PERIOD_MS));
+    }
+}
+
+} // namespace ::
+
+namespace dei::platform {
+
+auto ProfilerInternName(const char* name) -> u32 {
+    auto& state = GetState();
+    std::lock_guard<std::mutex> lock{state.Mutex};
+    auto found = state.NameIds.find(name);
+    if (found != state.NameIds.end()) {
+        return found->second;
+    }
+    auto id = static_cast<u32>(state.Names.size());
+    state.Names.emplace_back(name);
+    state.NameIds.emplace(name, id);
+    return id;
+}
+
+auto ProfilerEmit(u32 nameId, ProfilerEventType type, u64 clockCounter) -> void {
+    if (GetState().IsRunning.load(std::memory_order_relaxed) == false) {
+        return;
+    }
+    if (threadBuffer == nullptr) {
+        threadBuffer = ::RegisterThreadBuffer();
+    }
+    auto head = threadBuffer->Head.load(std::memory_order_relaxed);
+    auto tail = threadBuffer->Tail.load(std::memory_order_acquire);
+    if (head - tail >= THREAD_BUFFER_CAPACITY) {
+        threadBuffer->NumDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    threadBuffer->Events[head & THREAD_BUFFER_MASK] = ::ProfilerEvent{clockCounter, nameId, type};
+    threadBuffer->Head.store(head + 1, std::memory_order_release);
+}
+
+auto ProfilerStart(const char* traceFilepath) -> b8 {
+    auto& state = GetState();
+    if (state.IsRunning.load()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock{state.Mutex};
+    state.TraceFile = std::fopen(traceFilepath, "w");
+    if (state.TraceFile == nullptr) {
+        return false;
+    }
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", state.TraceFile);
+    state.HasWrittenEvents = false;
+    state.StartClockCounter = GetClockCounter();
+    state.CounterToMicrosec = 1e6 / static_cast<f64>(GetClockFrequencyHertz());
+    // discard whatever was left from a previous session
+    for (auto* buffer : state.ThreadBuffers) {
+        buffer->Tail.store(buffer->Head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+    state.IsRunning.store(true, std::memory_order_release);
+    state.Writer = std::thread{&::WriterLoop};
+    return true;
+}
+
+auto ProfilerStop() -> void {
+    auto& state = GetState();
+    if (state.IsRunning.exchange(false) == false) {
+        return;
+    }
+    state.Writer.join();
+    std::lock_guard<std::mutex> lock{state.Mutex};
+    ::DrainThreadBuffers(state);
+    std::fputs("\n]}\n", state.TraceFile);
+    std::fclose(state.TraceFile);
+    state.TraceFile = nullptr;
+    u64 numDropped = 0;
+    for (auto* buffer : state.ThreadBuffers) {
+        numDropped += buffer->NumDropped.exchange(0);
+    }
+    if (numDropped > 0) {
+        printf("Profiler: dropped %lu events, thread buffers were full\n", numDropped);
+    }
+}
+
+auto ProfilerIsRunning() -> b8 {
+    return GetState().IsRunning.load(std::memory_order_relaxed);
+}
+
+}
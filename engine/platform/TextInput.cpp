@@ -0,0 +1,180 @@
+#include "dei_platform/TextInput.hpp"
+#include "dei_platform/Utf8.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+using namespace dei;
+using platform::input::TextBuffer;
+using platform::input::TextEdit;
+using platform::input::TextEditType;
+
+inline auto IsContinuationByte(char byte) -> b8 {
+    return (static_cast<u8>(byte) & 0xC0) == 0x80;
+}
+
+inline auto TailSize(const TextBuffer& buffer) -> u32 {
+    return static_cast<u32>(buffer.Storage.size()) - buffer.GapEnd;
+}
+
+// moves the gap (and the cursor) to offsetBytes of the text
+auto MoveGap(TextBuffer& buffer, u32 offsetBytes) -> void {
+    auto* storage = buffer.Storage.data();
+    if (offsetBytes < buffer.GapBegin) {
+        auto numBytes = buffer.GapBegin - offsetBytes;
+        std::memmove(storage + buffer.GapEnd - numBytes, storage + offsetBytes, numBytes);
+        buffer.GapBegin -= numBytes;
+        buffer.GapEnd -= numBytes;
+    } else if (offsetBytes > buffer.GapBegin) {
+        auto numBytes = offsetBytes - buffer.GapBegin;
+        std::memmove(storage + buffer.GapBegin, storage + buffer.GapEnd, numBytes);
+        buffer.GapBegin += numBytes;
+        buffer.GapEnd += numBytes;
+    }
+}
+
+auto ReserveGap(TextBuffer& buffer, u32 numBytes) -> void {
+    if (buffer.GapEnd - buffer.GapBegin >= numBytes) {
+        return;
+    }
+    auto tailSize = ::TailSize(buffer);
+    auto oldSize = buffer.Storage.size();
+    auto newSize = std::max(oldSize * 2, oldSize + numBytes + 64);
+    buffer.Storage.resize(newSize);
+    auto newGapEnd = static_cast<u32>(newSize) - tailSize;
+    std::memmove(buffer.Storage.data() + newGapEnd, buffer.Storage.data() + buffer.GapEnd, tailSize);
+    buffer.GapEnd = newGapEnd;
+}
+
+// inserts at offsetBytes without touching the undo history
+auto InsertAt(TextBuffer& buffer, u32 offsetBytes, std::string_view textUtf8) -> TextEdit {
+    auto numBytes = static_cast<u32>(textUtf8.size());
+    ::ReserveGap(buffer, numBytes);
+    ::MoveGap(buffer, offsetBytes);
+    auto* inserted = buffer.Storage.data() + buffer.GapBegin;
+    std::memcpy(inserted, textUtf8.data(), numBytes);
+    buffer.GapBegin += numBytes;
+    return TextEdit{ TextEditType::INSERT, offsetBytes, {inserted, numBytes}, platform::input::TextBufferSize(buffer) };
+}
+
+// erases [offsetBytes, offsetBytes + numBytes) without touching the undo history,
+// the erased bytes stay in the gap, so the returned view is valid until the next edit
+auto EraseAt(TextBuffer& buffer, u32 offsetBytes, u32 numBytes) -> TextEdit {
+    ::MoveGap(buffer, offsetBytes + numBytes);
+    buffer.GapBegin -= numBytes;
+    const auto* erased = buffer.Storage.data() + buffer.GapBegin;
+    return TextEdit{ TextEditType::ERASE, offsetBytes, {erased, numBytes}, platform::input::TextBufferSize(buffer) };
+}
+
+auto PushUndoRecord(TextBuffer& buffer, const TextEdit& edit) -> void {
+    if (edit.TextUtf8.empty()) {
+        return;
+    }
+    if (buffer.UndoRecords.size() >= platform::input::TEXT_UNDO_MAX_RECORDS) {
+        // forget the older half at once, so the history is trimmed rarely
+        auto numForgotten = buffer.UndoRecords.size() / 2;
+        auto firstKept = buffer.UndoRecords.begin() + static_cast<std::ptrdiff_t>(numForgotten);
+        auto numBytesForgotten = firstKept->UndoBytesOffset;
+        buffer.UndoRecords.erase(buffer.UndoRecords.begin(), firstKept);
+        buffer.UndoBytes.erase(0, numBytesForgotten);
+        for (auto& record : buffer.UndoRecords) {
+            record.UndoBytesOffset -= numBytesForgotten;
+        }
+    }
+    auto record = platform::input::TextUndoRecord{
+        edit.Type, edit.OffsetBytes, static_cast<u32>(edit.TextUtf8.size()), static_cast<u32>(buffer.UndoBytes.size()),
+    };
+    // inserted text is still in the buffer when undone, only erased text is kept
+    if (edit.Type == TextEditType::ERASE) {
+        buffer.UndoBytes.append(edit.TextUtf8);
+    }
+    buffer.UndoRecords.push_back(record);
+}
+
+} // namespace ::
+
+namespace dei::platform::input {
+
+auto TextBufferSize(const TextBuffer& buffer) -> u32 {
+    return buffer.GapBegin + ::TailSize(buffer);
+}
+
+auto TextBufferCursor(const TextBuffer& buffer) -> u32 {
+    return buffer.GapBegin;
+}
+
+auto TextBufferInsert(TextBuffer& buffer, std::string_view textUtf8) -> TextEdit {
+    auto edit = ::InsertAt(buffer, buffer.GapBegin, textUtf8);
+    ::PushUndoRecord(buffer, edit);
+    return edit;
+}
+
+auto TextBufferInsertCodepoint(TextBuffer& buffer, u32 codepoint) -> std::optional<TextEdit> {
+    char encoded[4];
+    auto numBytes = platform::Utf8EncodeCodepoint(codepoint, encoded);
+    if (numBytes == 0) {
+        return std::nullopt;
+    }
+    return TextBufferInsert(buffer, std::string_view{encoded, numBytes});
+}
+
+auto TextBufferErase(TextBuffer& buffer, u32 numCodepoints) -> TextEdit {
+    auto begin = buffer.GapBegin;
+    const auto* storage = buffer.Storage.data();
+    for (u32 i = 0; i < numCodepoints && begin > 0; ++i) {
+        do {
+            --begin;
+        } while (begin > 0 && ::IsContinuationByte(storage[begin]));
+    }
+    auto edit = ::EraseAt(buffer, begin, buffer.GapBegin - begin);
+    ::PushUndoRecord(buffer, edit);
+    return edit;
+}
+
+auto TextBufferClear(TextBuffer& buffer) -> TextEdit {
+    auto edit = ::EraseAt(buffer, 0, TextBufferSize(buffer));
+    ::PushUndoRecord(buffer, edit);
+    return edit;
+}
+
+auto TextBufferMoveCursor(TextBuffer& buffer, i32 numCodepoints) -> void {
+    auto offset = buffer.GapBegin;
+    const auto* storage = buffer.Storage.data();
+    for (; numCodepoints < 0 && offset > 0; ++numCodepoints) {
+        do {
+            --offset;
+        } while (offset > 0 && ::IsContinuationByte(storage[offset]));
+    }
+    // the text after the cursor starts at GapEnd
+    auto size = TextBufferSize(buffer);
+    for (; numCodepoints > 0 && offset < size; --numCodepoints) {
+        do {
+            ++offset;
+        } while (offset < size && ::IsContinuationByte(storage[buffer.GapEnd + offset - buffer.GapBegin]));
+    }
+    ::MoveGap(buffer, offset);
+}
+
+auto TextBufferUndo(TextBuffer& buffer) -> std::optional<TextEdit> {
+    if (buffer.UndoRecords.empty()) {
+        return std::nullopt;
+    }
+    auto record = buffer.UndoRecords.back();
+    buffer.UndoRecords.pop_back();
+    if (record.Type == TextEditType::INSERT) {
+        return ::EraseAt(buffer, record.OffsetBytes, record.NumBytes);
+    }
+    auto edit = ::InsertAt(buffer, record.OffsetBytes,
+        std::string_view{buffer.UndoBytes}.substr(record.UndoBytesOffset, record.NumBytes));
+    buffer.UndoBytes.resize(record.UndoBytesOffset);
+    return edit;
+}
+
+auto TextBufferCopyUtf8(const TextBuffer& buffer, std::string& destination) -> void {
+    destination.assign(buffer.Storage.data(), buffer.GapBegin);
+    destination.append(buffer.Storage.data() + buffer.GapEnd, ::TailSize(buffer));
+}
+
+}
@@ -0,0 +1,361 @@
+#include "dei_platform/Utf8.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define DEI_UTF8_X86 1
+#endif
+
+namespace {
+
+using namespace dei;
+using platform::SimdLevel;
+
+// per lead byte: length of the sequence (0 - can't start one) and the range of the second byte,
+// which is narrower after E0, ED, F0, F4 to reject overlong forms, surrogates and values past U+10FFFF
+struct LeadByteInfo {
+    u8 Length;
+    u8 SecondMin;
+    u8 SecondMax;
+};
+
+constexpr auto MakeLeadByteTable() -> std::array<LeadByteInfo, 256> {
+    auto table = std::array<LeadByteInfo, 256>{};
+    for (u32 byte = 0; byte < 0x80; ++byte) {
+        table[byte] = LeadByteInfo{ 1, 0, 0 };
+    }
+    for (u32 byte = 0xC2; byte < 0xE0; ++byte) {
+        table[byte] = LeadByteInfo{ 2, 0x80, 0xBF };
+    }
+    for (u32 byte = 0xE0; byte < 0xF0; ++byte) {
+        table[byte] = LeadByteInfo{ 3, 0x80, 0xBF };
+    }
+    table[0xE0].SecondMin = 0xA0;
+    table[0xED].SecondMax = 0x9F;
+    for (u32 byte = 0xF0; byte < 0xF5; ++byte) {
+        table[byte] = LeadByteInfo{ 4, 0x80, 0xBF };
+    }
+    table[0xF0].SecondMin = 0x90;
+    table[0xF4].SecondMax = 0x8F;
+    return table;
+}
+
+constexpr auto LEAD_BYTES = MakeLeadByteTable();
+constexpr u8 NO_FORCED_LEVEL = 0xFF;
+
+std::atomic<u8> forcedSimdLevel{NO_FORCED_LEVEL};
+
+auto DetectSimdLevel() -> SimdLevel {
+#if defined(DEI_UTF8_X86)
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+    return SimdLevel::SSE2;
+#else
+    return SimdLevel::SCALAR;
+#endif
+}
+
+// validates and decodes one sequence, returns its length or 0 if it's invalid
+inline auto DecodeSequence(const u8* source, size_t numBytes, u32& codepoint) -> u32 {
+    auto info = LEAD_BYTES[source[0]];
+    if (info.Length == 0 || info.Length > numBytes) {
+        return 0;
+    }
+    if (info.Length == 1) {
+        codepoint = source[0];
+        return 1;
+    }
+    if (source[1] < info.SecondMin || source[1] > info.SecondMax) {
+        return 0;
+    }
+    u32 decoded = source[0] & (0x7Fu >> info.Length);
+    decoded = (decoded << 6) | (source[1] & 0x3Fu);
+    for (u32 i = 2; i < info.Length; ++i) {
+        if ((source[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+        decoded = (decoded << 6) | (source[i] & 0x3Fu);
+    }
+    codepoint = decoded;
+    return info.Length;
+}
+
+// the ASCII runs are handled by block, the rest of the text - by sequence
+// each helper returns the number of leading ASCII bytes (codepoints) it processed
+
+auto CountAsciiScalar(const u8* source, size_t numBytes) -> size_t {
+    size_t i = 0;
+    for (; i + 8 <= numBytes; i += 8) {
+        u64 block;
+        std::memcpy(&block, source + i, sizeof(block));
+        if (auto highBits = block & 0x8080808080808080ULL; highBits != 0) {
+            return i + static_cast<size_t>(__builtin_ctzll(highBits) / 8);
+        }
+    }
+    while (i < numBytes && source[i] < 0x80) {
+        ++i;
+    }
+    return i;
+}
+
+auto WidenAsciiScalar(const u8* source, size_t numBytes, char32_t* destination) -> size_t {
+    size_t i = 0;
+    while (i < numBytes && source[i] < 0x80) {
+        destination[i] = source[i];
+        ++i;
+    }
+    return i;
+}
+
+auto NarrowAsciiScalar(const char32_t* source, size_t numCodepoints, u8* destination) -> size_t {
+    size_t i = 0;
+    while (i < numCodepoints && source[i] < 0x80) {
+        destination[i] = static_cast<u8>(source[i]);
+        ++i;
+    }
+    return i;
+}
+
+#if defined(DEI_UTF8_X86)
+
+auto CountAsciiSse2(const u8* source, size_t numBytes) -> size_t {
+    size_t i = 0;
+    for (; i + 16 <= numBytes; i += 16) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        if (auto mask = static_cast<u32>(_mm_movemask_epi8(block)); mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    return i + ::CountAsciiScalar(source + i, numBytes - i);
+}
+
+auto WidenAsciiSse2(const u8* source, size_t numBytes, char32_t* destination) -> size_t {
+    size_t i = 0;
+    auto zero = _mm_setzero_si128();
+    for (; i + 16 <= numBytes; i += 16) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        if (_mm_movemask_epi8(block) != 0) {
+            break;
+        }
+        auto low = _mm_unpacklo_epi8(block, zero);
+        auto high = _mm_unpackhi_epi8(block, zero);
+        auto* out = reinterpret_cast<__m128i*>(destination + i);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(low, zero));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(low, zero));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(high, zero));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(high, zero));
+    }
+    return i + ::WidenAsciiScalar(source + i, numBytes - i, destination + i);
+}
+
+auto NarrowAsciiSse2(const char32_t* source, size_t numCodepoints, u8* destination) -> size_t {
+    size_t i = 0;
+    auto nonAsciiBits = _mm_set1_epi32(~0x7F);
+    for (; i + 8 <= numCodepoints; i += 8) {
+        auto first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        auto second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 4));
+        auto outside = _mm_and_si128(_mm_or_si128(first, second), nonAsciiBits);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(outside, _mm_setzero_si128())) != 0xFFFF) {
+            break;
+        }
+        auto packed16 = _mm_packs_epi32(first, second);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(destination + i), _mm_packus_epi16(packed16, packed16));
+    }
+    return i + ::NarrowAsciiScalar(source + i, numCodepoints - i, destination + i);
+}
+
+// the AVX2 helpers finish with scalar code, not with the SSE2 helpers:
+// those are compiled without VEX encoding and would stall on the AVX-SSE transition
+__attribute__((target("avx2")))
+auto CountAsciiAvx2(const u8* source, size_t numBytes) -> size_t {
+    size_t i = 0;
+    for (; i + 32 <= numBytes; i += 32) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        if (auto mask = static_cast<u32>(_mm256_movemask_epi8(block)); mask != 0) {
+            return i + static_cast<size_t>(__builtin_ctz(mask));
+        }
+    }
+    return i + ::CountAsciiScalar(source + i, numBytes - i);
+}
+
+__attribute__((target("avx2")))
+auto WidenAsciiAvx2(const u8* source, size_t numBytes, char32_t* destination) -> size_t {
+    size_t i = 0;
+    for (; i + 32 <= numBytes; i += 32) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        if (_mm256_movemask_epi8(block) != 0) {
+            break;
+        }
+        auto* out = reinterpret_cast<__m256i*>(destination + i);
+        for (u32 part = 0; part < 4; ++part) {
+            auto bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source + i + part * 8));
+            _mm256_storeu_si256(out + part, _mm256_cvtepu8_epi32(bytes));
+        }
+    }
+    return i + ::WidenAsciiScalar(source + i, numBytes - i, destination + i);
+}
+
+__attribute__((target("avx2")))
+auto NarrowAsciiAvx2(const char32_t* source, size_t numCodepoints, u8* destination) -> size_t {
+    size_t i = 0;
+    auto nonAsciiBits = _mm256_set1_epi32(~0x7F);
+    // after the in-lane packs the 4 byte groups are in order 0, 4, 1, 5
+    auto order = _mm256_setr_epi32(0, 4, 1, 5, 0, 0, 0, 0);
+    for (; i + 16 <= numCodepoints; i += 16) {
+        auto first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+        auto second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 8));
+        if (_mm256_testz_si256(_mm256_or_si256(first, second), nonAsciiBits) == 0) {
+            break;
+        }
+        auto packed16 = _mm256_packus_epi32(first, second);
+        auto packed8 = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(packed16, packed16), order);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm256_castsi256_si128(packed8));
+    }
+    return i + ::NarrowAsciiScalar(source + i, numCodepoints - i, destination + i);
+}
+
+#endif
+
+inline auto CountAscii(SimdLevel level, const u8* source, size_t numBytes) -> size_t {
+#if defined(DEI_UTF8_X86)
+    switch (level) {
+        case SimdLevel::AVX2: return ::CountAsciiAvx2(source, numBytes);
+        case SimdLevel::SSE2: return ::CountAsciiSse2(source, numBytes);
+        case SimdLevel::SCALAR: break;
+    }
+#endif
+    (void)level;
+    return ::CountAsciiScalar(source, numBytes);
+}
+
+inline auto WidenAscii(SimdLevel level, const u8* source, size_t numBytes, char32_t* destination) -> size_t {
+#if defined(DEI_UTF8_X86)
+    switch (level) {
+        case SimdLevel::AVX2: return ::WidenAsciiAvx2(source, numBytes, destination);
+        case SimdLevel::SSE2: return ::WidenAsciiSse2(source, numBytes, destination);
+        case SimdLevel::SCALAR: break;
+    }
+#endif
+    (void)level;
+    return ::WidenAsciiScalar(source, numBytes, destination);
+}
+
+inline auto NarrowAscii(SimdLevel level, const char32_t* source, size_t numCodepoints, u8* destination) -> size_t {
+#if defined(DEI_UTF8_X86)
+    switch (level) {
+        case SimdLevel::AVX2: return ::NarrowAsciiAvx2(source, numCodepoints, destination);
+        case SimdLevel::SSE2: return ::NarrowAsciiSse2(source, numCodepoints, destination);
+        case SimdLevel::SCALAR: break;
+    }
+#endif
+    (void)level;
+    return ::NarrowAsciiScalar(source, numCodepoints, destination);
+}
+
+} // namespace ::
+
+namespace dei::platform {
+
+auto Utf8GetSimdLevel() -> SimdLevel {
+    static const auto detectedLevel = ::DetectSimdLevel();
+    auto forcedLevel = forcedSimdLevel.load(std::memory_order_relaxed);
+    if (forcedLevel == NO_FORCED_LEVEL || forcedLevel > static_cast<u8>(detectedLevel)) {
+        return detectedLevel;
+    }
+    return static_cast<SimdLevel>(forcedLevel);
+}
+
+auto Utf8ForceSimdLevel(SimdLevel level) -> void {
+    forcedSimdLevel.store(static_cast<u8>(level), std::memory_order_relaxed);
+}
+
+auto Utf8Validate(const char* sourceUtf8, size_t numBytes) -> b8 {
+    auto level = Utf8GetSimdLevel();
+    const auto* source = reinterpret_cast<const u8*>(sourceUtf8);
+    size_t i = 0;
+    while (i < numBytes) {
+        i += ::CountAscii(level, source + i, numBytes - i);
+        while (i < numBytes && source[i] >= 0x80) {
+            u32 codepoint;
+            auto length = ::DecodeSequence(source + i, numBytes - i, codepoint);
+            if (length == 0) {
+                return false;
+            }
+            i += length;
+        }
+    }
+    return true;
+}
+
+auto Utf8CountCodepoints(const char* sourceUtf8, size_t numBytes) -> size_t {
+    size_t numCodepoints = 0;
+    for (size_t i = 0; i < numBytes; ++i) {
+        numCodepoints += (static_cast<u8>(sourceUtf8[i]) & 0xC0) != 0x80;
+    }
+    return numCodepoints;
+}
+
+auto Utf8ToUtf32(const char* sourceUtf8, size_t numBytes, char32_t* destination) -> std::optional<size_t> {
+    auto level = Utf8GetSimdLevel();
+    const auto* source = reinterpret_cast<const u8*>(sourceUtf8);
+    size_t i = 0;
+    size_t numWritten = 0;
+    while (i < numBytes) {
+        auto numAscii = ::WidenAscii(level, source + i, numBytes - i, destination + numWritten);
+        i += numAscii;
+        numWritten += numAscii;
+        while (i < numBytes && source[i] >= 0x80) {
+            u32 codepoint;
+            auto length = ::DecodeSequence(source + i, numBytes - i, codepoint);
+            if (length == 0) {
+                return std::nullopt;
+            }
+            destination[numWritten++] = codepoint;
+            i += length;
+        }
+    }
+    return numWritten;
+}
+
+auto Utf32ToUtf8(const char32_t* source, size_t numCodepoints, char* destinationUtf8) -> std::optional<size_t> {
+    auto level = Utf8GetSimdLevel();
+    auto* destination = reinterpret_cast<u8*>(destinationUtf8);
+    size_t i = 0;
+    size_t numWritten = 0;
+    while (i < numCodepoints) {
+        auto numAscii = ::NarrowAscii(level, source + i, numCodepoints - i, destination + numWritten);
+        i += numAscii;
+        numWritten += numAscii;
+        while (i < numCodepoints && source[i] >= 0x80) {
+            auto length = Utf8EncodeCodepoint(source[i], destinationUtf8 + numWritten);
+            if (length == 0) {
+                return std::nullopt;
+            }
+            numWritten += length;
+            ++i;
+        }
+    }
+    return numWritten;
+}
+
+auto AppendUtf32AsUtf8(std::string& destination, std::u32string_view source) -> b8 {
+    auto oldSize = destination.size();
+    destination.resize(oldSize + source.size() * 4);
+    auto numWritten = Utf32ToUtf8(source.data(), source.size(), destination.data() + oldSize);
+    destination.resize(oldSize + numWritten.value_or(0));
+    return numWritten.has_value();
+}
+
+auto AppendUtf8AsUtf32(std::u32string& destination, std::string_view sourceUtf8) -> b8 {
+    auto oldSize = destination.size();
+    destination.resize(oldSize + sourceUtf8.size());
+    auto numWritten = Utf8ToUtf32(sourceUtf8.data(), sourceUtf8.size(), destination.data() + oldSize);
+    destination.resize(oldSize + numWritten.value_or(0));
+    return numWritten.has_value();
+}
+
+}
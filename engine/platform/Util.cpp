@@ -1,7 +1,6 @@
 #include "dei_platform/Prelude.hpp"
 #include "dei_platform/Util.hpp"
 
-#include <sstream>
 #include <cstring>
 
 namespace dei::platform {
@@ -0,0 +1,345 @@
+#include "dei_platform/VulkanAllocator.hpp"
+#include "dei_platform/Allocation.hpp"
+#include "dei_platform/Log.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+namespace {
+
+using dei::platform::VULKAN_ALLOCATION_SCOPE_COUNT;
+
+constexpr size_t COMMAND_ARENA_BYTES = 256 * 1024;
+constexpr size_t POOL_SLAB_BYTES = 64 * 1024;
+constexpr size_t POOL_SLAB_ALIGNMENT = 4096;
+constexpr u32 POOL_MIN_CLASS_SHIFT = 5;
+constexpr u32 POOL_NUM_CLASSES = 8; // 32 bytes .. 4 KiB
+constexpr size_t HEADER_BYTES = 16;
+// threads that called into Vulkan with COMMAND allocations, the later ones fall back to the pools
+constexpr u32 MAX_COMMAND_ARENAS = 1024;
+
+enum class BlockSource : u8 {
+    ARENA,
+    POOL,
+    HEAP,
+};
+
+// right before every returned pointer
+struct BlockHeader {
+    u64 Size;
+    // from the start of the underlying block to the returned pointer, HEADER_BYTES at least
+    u32 Padding;
+    BlockSource Source;
+    u8 Scope;
+    // POOL: the size class, ARENA: the owning thread's arena in VulkanAllocatorState::Arenas
+    u16 Slot;
+};
+static_assert(sizeof(BlockHeader) == HEADER_BYTES);
+
+struct FreeChunk {
+    FreeChunk* Next;
+};
+
+struct ScopeCounters {
+    std::atomic<u64> NumAllocations{0};
+    std::atomic<u64> NumLive{0};
+    std::atomic<u64> LiveBytes{0};
+    std::atomic<u64> PeakBytes{0};
+};
+
+// COMMAND allocations only live during the Vulkan call that made them, on the calling thread.
+// Never freed, a thread's arena is reused for the thread's lifetime. Only the owner moves Offset,
+// a driver may free on another thread though, so NumLive is shared
+struct CommandArena {
+    u8* Data;
+    size_t Offset;
+    std::atomic<u32> NumLive;
+};
+
+struct VulkanAllocatorState {
+    std::mutex PoolMutex; // guards FreeChunks
+    FreeChunk* FreeChunks[POOL_NUM_CLASSES]{};
+    ScopeCounters Scopes[VULKAN_ALLOCATION_SCOPE_COUNT];
+    std::atomic<u64> InternalBytes{0};
+    std::atomic<u64> NumArenaOverflows{0};
+    std::atomic<u64> ArenaPeakBytes{0};
+    CommandArena* Arenas[MAX_COMMAND_ARENAS]{};
+    std::atomic<u32> NumArenas{0};
+    VkAllocationCallbacks Callbacks{};
+};
+
+auto Allocate(void* userData, size_t numBytes, size_t alignment, VkSystemAllocationScope scope) -> void*;
+auto Reallocate(void* userData, void* original, size_t numBytes, size_t alignment, VkSystemAllocationScope scope) -> void*;
+auto Free(void* userData, void* pointer) -> void;
+auto OnInternalAllocation(void* userData, size_t numBytes, VkInternalAllocationType, VkSystemAllocationScope) -> void;
+auto OnInternalFree(void* userData, size_t numBytes, VkInternalAllocationType, VkSystemAllocationScope) -> void;
+
+auto MakeState() -> VulkanAllocatorState* {
+    auto* state = new VulkanAllocatorState{};
+    state->Callbacks.pUserData = state;
+    state->Callbacks.pfnAllocation = &::Allocate;
+    state->Callbacks.pfnReallocation = &::Reallocate;
+    state->Callbacks.pfnFree = &::Free;
+    state->Callbacks.pfnInternalAllocation = &::OnInternalAllocation;
+    state->Callbacks.pfnInternalFree = &::OnInternalFree;
+    return state;
+}
+
+// never destroyed: the driver may free through the callbacks until the process exits
+auto GetState() -> VulkanAllocatorState& {
+    static auto* state = ::MakeState();
+    return *state;
+}
+
+thread_local CommandArena* commandArena = nullptr;
+thread_local u16 commandArenaSlot = 0;
+
+inline auto HeaderOf(void* pointer) -> BlockHeader* {
+    return reinterpret_cast<BlockHeader*>(static_cast<u8*>(pointer) - HEADER_BYTES);
+}
+
+inline auto AtomicMax(std::atomic<u64>& value, u64 candidate) -> void {
+    auto current = value.load(std::memory_order_relaxed);
+    while (current < candidate && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed)) {}
+}
+
+// the header fits in front of the pointer and keeps it aligned
+inline auto PaddingFor(size_t alignment) -> u32 {
+    return static_cast<u32>(std::max(alignment, HEADER_BYTES));
+}
+
+// POOL_NUM_CLASSES if the size doesn't fit any class
+inline auto SizeClassOf(size_t numBytes) -> u32 {
+    u32 sizeClass = 0;
+    while (sizeClass < POOL_NUM_CLASSES && (size_t{1} << (POOL_MIN_CLASS_SHIFT + sizeClass)) < numBytes) {
+        ++sizeClass;
+    }
+    return sizeClass;
+}
+
+auto HeapAllocate(size_t numBytes, size_t alignment) -> u8* {
+    auto allocationTag = dei::platform::AllocationTagScope{dei::platform::AllocationTag::VULKAN};
+    return static_cast<u8*>(::operator new(numBytes, std::align_val_t{alignment}, std::nothrow));
+}
+
+auto HeapFree(void* pointer, size_t alignment) -> void {
+    auto allocationTag = dei::platform::AllocationTagScope{dei::platform::AllocationTag::VULKAN};
+    ::operator delete(pointer, std::align_val_t{alignment});
+}
+
+// the calling thread's arena, null if every slot is taken or it can't be allocated
+auto GetCommandArena(VulkanAllocatorState& state) -> CommandArena* {
+    if (commandArena != nullptr) {
+        return commandArena;
+    }
+    auto slot = state.NumArenas.fetch_add(1, std::memory_order_relaxed);
+    if (slot >= MAX_COMMAND_ARENAS) {
+        return nullptr;
+    }
+    auto* data = ::HeapAllocate(COMMAND_ARENA_BYTES, POOL_SLAB_ALIGNMENT);
+    if (data == nullptr) {
+        // the slot stays unused
+        return nullptr;
+    }
+    auto allocationTag = dei::platform::AllocationTagScope{dei::platform::AllocationTag::VULKAN};
+    auto* arena = new CommandArena{ data, 0, {0} };
+    // published before any block of the arena exists, a freeing thread got the block through the driver
+    state.Arenas[slot] = arena;
+    commandArena = arena;
+    commandArenaSlot = static_cast<u16>(slot);
+    return arena;
+}
+
+auto ArenaAllocate(VulkanAllocatorState& state, size_t numBytes, u32 padding) -> u8* {
+    auto* arena = ::GetCommandArena(state);
+    if (arena == nullptr) {
+        return nullptr;
+    }
+    if (arena->NumLive.load(std::memory_order_acquire) == 0) {
+        // the last block may have been freed by another thread, which leaves the rewind to the owner
+        arena->Offset = 0;
+    }
+    // the padding is a multiple of the alignment, so aligning the base aligns the returned pointer
+    auto begin = (arena->Offset + padding - 1) / padding * padding;
+    if (begin + padding + numBytes > COMMAND_ARENA_BYTES) {
+        return nullptr;
+    }
+    arena->Offset = begin + padding + numBytes;
+    arena->NumLive.fetch_add(1, std::memory_order_relaxed);
+    ::AtomicMax(state.ArenaPeakBytes, arena->Offset);
+    return arena->Data + begin;
+}
+
+auto ArenaFree(VulkanAllocatorState& state, u16 slot) -> void {
+    auto* arena = state.Arenas[slot];
+    if (arena->NumLive.fetch_sub(1, std::memory_order_acq_rel) == 1 && arena == commandArena) {
+        arena->Offset = 0;
+    }
+}
+
+auto PoolAllocate(VulkanAllocatorState& state, u32 sizeClass) -> u8* {
+    std::lock_guard<std::mutex> lock{state.PoolMutex};
+    auto& freeChunks = state.FreeChunks[sizeClass];
+    if (freeChunks == nullptr) {
+        auto chunkBytes = size_t{1} << (POOL_MIN_CLASS_SHIFT + sizeClass);
+        auto* slab = ::HeapAllocate(POOL_SLAB_BYTES, POOL_SLAB_ALIGNMENT);
+        if (slab == nullptr) {
+            return nullptr;
+        }
+        // slabs stay in the pool for good, they're few since drivers reuse their objects
+        for (auto offset = POOL_SLAB_BYTES; offset >= chunkBytes; offset -= chunkBytes) {
+            auto* chunk = reinterpret_cast<FreeChunk*>(slab + offset - chunkBytes);
+            chunk->Next = freeChunks;
+            freeChunks = chunk;
+        }
+    }
+    auto* chunk = freeChunks;
+    freeChunks = chunk->Next;
+    return reinterpret_cast<u8*>(chunk);
+}
+
+auto PoolFree(VulkanAllocatorState& state, u32 sizeClass, u8* base) -> void {
+    std::lock_guard<std::mutex> lock{state.PoolMutex};
+    auto* chunk = reinterpret_cast<FreeChunk*>(base);
+    chunk->Next = state.FreeChunks[sizeClass];
+    state.FreeChunks[sizeClass] = chunk;
+}
+
+auto Allocate(void* userData, size_t numBytes, size_t alignment, VkSystemAllocationScope scope) -> void* {
+    auto& state = *static_cast<VulkanAllocatorState*>(userData);
+    auto padding = ::PaddingFor(alignment);
+    auto scopeIndex = std::min(static_cast<u32>(scope), VULKAN_ALLOCATION_SCOPE_COUNT - 1);
+    auto header = BlockHeader{ numBytes, padding, BlockSource::HEAP, static_cast<u8>(scopeIndex), 0 };
+    u8* base = nullptr;
+    if (alignment > POOL_SLAB_ALIGNMENT) {
+        // neither the arena nor the slabs are aligned enough
+    } else if (scope == VK_SYSTEM_ALLOCATION_SCOPE_COMMAND) {
+        base = ::ArenaAllocate(state, numBytes, padding);
+        header.Source = BlockSource::ARENA;
+        header.Slot = commandArenaSlot;
+        if (base == nullptr) {
+            state.NumArenaOverflows.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else if (auto sizeClass = ::SizeClassOf(padding + numBytes); sizeClass < POOL_NUM_CLASSES) {
+        // chunks are aligned to their size, which is at least padding
+        base = ::PoolAllocate(state, sizeClass);
+        header.Source = BlockSource::POOL;
+        header.Slot = static_cast<u16>(sizeClass);
+    }
+    if (base == nullptr) {
+        base = ::HeapAllocate(padding + numBytes, padding);
+        header.Source = BlockSource::HEAP;
+        if (base == nullptr) {
+            return nullptr;
+        }
+    }
+    auto* pointer = base + padding;
+    std::memcpy(::HeaderOf(pointer), &header, sizeof(header));
+
+    auto& counters = state.Scopes[scopeIndex];
+    counters.NumAllocations.fetch_add(1, std::memory_order_relaxed);
+    counters.NumLive.fetch_add(1, std::memory_order_relaxed);
+    auto liveBytes = counters.LiveBytes.fetch_add(numBytes, std::memory_order_relaxed) + numBytes;
+    ::AtomicMax(counters.PeakBytes, liveBytes);
+    return pointer;
+}
+
+auto Free(void* userData, void* pointer) -> void {
+    if (pointer == nullptr) {
+        return;
+    }
+    auto& state = *static_cast<VulkanAllocatorState*>(userData);
+    auto header = BlockHeader{};
+    std::memcpy(&header, ::HeaderOf(pointer), sizeof(header));
+    auto& counters = state.Scopes[header.Scope];
+    counters.NumLive.fetch_sub(1, std::memory_order_relaxed);
+    counters.LiveBytes.fetch_sub(header.Size, std::memory_order_relaxed);
+    auto* base = static_cast<u8*>(pointer) - header.Padding;
+    switch (header.Source) {
+        case BlockSource::ARENA: ::ArenaFree(state, header.Slot); break;
+        case BlockSource::POOL: ::PoolFree(state, header.Slot, base); break;
+        case BlockSource::HEAP: ::HeapFree(base, header.Padding); break;
+    }
+}
+
+auto Reallocate(void* userData, void* original, size_t numBytes, size_t alignment, VkSystemAllocationScope scope)
+    -> void* {
+    if (original == nullptr) {
+        return ::Allocate(userData, numBytes, alignment, scope);
+    }
+    if (numBytes == 0) {
+        ::Free(userData, original);
+        return nullptr;
+    }
+    auto* pointer = ::Allocate(userData, numBytes, alignment, scope);
+    if (pointer == nullptr) {
+        // the original stays valid
+        return nullptr;
+    }
+    std::memcpy(pointer, original, std::min<size_t>(numBytes, ::HeaderOf(original)->Size));
+    ::Free(userData, original);
+    return pointer;
+}
+
+auto OnInternalAllocation(void* userData, size_t numBytes, VkInternalAllocationType, VkSystemAllocationScope) -> void {
+    static_cast<VulkanAllocatorState*>(userData)->InternalBytes.fetch_add(numBytes, std::memory_order_relaxed);
+}
+
+auto OnInternalFree(void* userData, size_t numBytes, VkInternalAllocationType, VkSystemAllocationScope) -> void {
+    static_cast<VulkanAllocatorState*>(userData)->InternalBytes.fetch_sub(numBytes, std::memory_order_relaxed);
+}
+
+} // namespace ::
+
+namespace dei::platform {
+
+auto GetVulkanAllocationCallbacks() -> const VkAllocationCallbacks* {
+    return &::GetState().Callbacks;
+}
+
+auto VulkanAllocatorBeginFrame() -> void {
+    auto* arena = commandArena;
+    if (arena == nullptr) {
+        return;
+    }
+    auto numLive = arena->NumLive.load(std::memory_order_acquire);
+    if (numLive > 0) {
+        DEI_LOG_WARN("VulkanAllocator: %u COMMAND allocations outlived their command\n", numLive);
+        return;
+    }
+    arena->Offset = 0;
+}
+
+auto VulkanAllocatorQueryStats() -> VulkanAllocationStats {
+    auto& state = ::GetState();
+    auto stats = VulkanAllocationStats{};
+    for (u32 scope = 0; scope < VULKAN_ALLOCATION_SCOPE_COUNT; ++scope) {
+        const auto& counters = state.Scopes[scope];
+        stats.Scopes[scope].NumAllocations = counters.NumAllocations.load(std::memory_order_relaxed);
+        stats.Scopes[scope].NumLive = counters.NumLive.load(std::memory_order_relaxed);
+        stats.Scopes[scope].LiveBytes = counters.LiveBytes.load(std::memory_order_relaxed);
+        stats.Scopes[scope].PeakBytes = counters.PeakBytes.load(std::memory_order_relaxed);
+        stats.LiveBytes += stats.Scopes[scope].LiveBytes;
+    }
+    stats.InternalBytes = state.InternalBytes.load(std::memory_order_relaxed);
+    stats.NumArenaOverflows = state.NumArenaOverflows.load(std::memory_order_relaxed);
+    stats.ArenaPeakBytes = state.ArenaPeakBytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+auto PrintVulkanAllocationStats() -> void {
+    auto stats = VulkanAllocatorQueryStats();
+    printf("Vulkan host allocations:\n");
+    for (u32 scope = 0; scope < VULKAN_ALLOCATION_SCOPE_COUNT; ++scope) {
+        const auto& scopeStats = stats.Scopes[scope];
+        printf("%12s: allocations=%lu live=%lu live bytes=%lu peak bytes=%lu\n", VulkanAllocationScopeToStr(scope),
+            scopeStats.NumAllocations, scopeStats.NumLive, scopeStats.LiveBytes, scopeStats.PeakBytes);
+    }
+    printf("Vulkan internal bytes=%lu, command arena peak=%lu bytes overflows=%lu\n",
+        stats.InternalBytes, stats.ArenaPeakBytes, stats.NumArenaOverflows);
+}
+
+}
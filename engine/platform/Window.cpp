@@ -1,5 +1,15 @@
 #include "dei_platform/Window.hpp"
-#include "dei_platform/Unicode.hpp"
+#include "dei_platform/Profiler.hpp"
+#include "dei_platform/Log.hpp"
+#include "dei_platform/Allocation.hpp"
+#include "dei_platform/Time.hpp"
+#include "dei_platform/InputRecording.hpp"
+#include "dei_platform/Utf8.hpp"
+#include "dei_platform/VulkanAllocator.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
 
 namespace {
 
@@ -10,7 +20,7 @@ struct WindowState {
     vec2i MonitorSize;
     platform::WindowSystemHandle WindowSystem;
     platform::input::KeyMap KeyMap;
-    std::string InputTextUtf8;
+    platform::input::TextBuffer InputText;
     platform::GraphicsApi GraphicsApi;
     b8 HasContextObject;
     platform::WindowPositionCallback WindowPositionCallback;
@@ -22,6 +32,24 @@ struct WindowState {
     platform::input::MouseButtonCallback MouseButtonCallback;
     platform::input::MouseScrollCallback MouseScrollCallback;
     platform::input::MouseEntersWindowCallback MouseEntersWindowCallback;
+    // incremented by every callback below, may be read from another thread
+    std::atomic<u64> NumEvents;
+    // arrival of the earliest input event since WindowTakeInputTimestamp, 0 if none
+    std::atomic<i64> EarliestInputNanosec;
+    // not null in the buffered input mode, then the callbacks above aren't called
+    platform::input::InputEventQueue* InputEvents;
+    platform::input::InputStateAccumulator InputState;
+    platform::input::InputSnapshot InputSnapshot;
+    platform::input::MouseMotionAccumulator MouseMotion;
+    platform::WindowSurfaceState SurfaceState;
+    // number of WindowBeginInputFrame calls, recorded with every event
+    u64 InputFrameIndex;
+    platform::input::InputRecording Recording;
+    b8 IsDispatchingReplay;
+    // see WindowGetFrameNanosec
+    i64 FrameNanosec;
+    // moves the replayed clock next to the live one, so it doesn't jump once the replay ends
+    i64 ReplayClockOffsetNanosec;
 };
 
 inline auto GetWindowState(const dei::platform::WindowHandle& window) -> WindowState* {
@@ -32,6 +60,47 @@ inline auto GetWindowState(GLFWwindow* window) -> WindowState* {
     return static_cast<WindowState*>(glfwGetWindowUserPointer(window));
 }
 
+using platform::input::InputEventType;
+
+inline auto MakeInputEvent(InputEventType type, i32 code,
+    i32 action = 0, i32 modifiers = 0, f64 x = 0.0, f64 y = 0.0) -> platform::input::InputEvent {
+    return platform::input::InputEvent{
+        platform::GetMonotonicNanosec(), type, static_cast<u8>(action), static_cast<u16>(modifiers), code, x, y,
+    };
+}
+
+// counts and records the event, returns false if it must be ignored:
+// while replaying only the recorded events are dispatched (closing the window still works)
+inline auto BeginInputEvent(WindowState* windowState, const platform::input::InputEvent& event) -> b8 {
+    windowState->NumEvents.fetch_add(1, std::memory_order_relaxed);
+    if (windowState->Recording.IsReplaying && !windowState->IsDispatchingReplay
+        && event.Type != InputEventType::WINDOW_CLOSING) {
+        return false;
+    }
+    platform::input::InputRecordingWrite(windowState->Recording, windowState->InputFrameIndex, event);
+    if (platform::input::InputEventIsUserInput(event.Type)) {
+        i64 noInput = 0;
+        windowState->EarliestInputNanosec.compare_exchange_strong(noInput, event.TimestampNanosec, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+// returns false if the window doesn't buffer input (then the event should be dispatched immediately)
+inline auto PushInputEvent(WindowState* windowState, const platform::input::InputEvent& event) -> b8 {
+    if (windowState->InputEvents == nullptr) {
+        return false;
+    }
+    platform::input::InputEventQueuePush(*windowState->InputEvents, event);
+    return true;
+}
+
+inline auto NotifyTextEdit(WindowState* windowState, const platform::input::TextEdit& edit) -> void {
+    if (edit.TextUtf8.empty() || windowState->InputTextCallback == nullptr) {
+        return;
+    }
+    windowState->InputTextCallback(edit);
+}
+
 inline auto SetGlfwVersionHint(u32 versionMajor, u32 versionMinor) -> void {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, static_cast<int>(versionMajor));
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, static_cast<int>(versionMinor));
@@ -40,48 +109,51 @@ inline auto SetGlfwVersionHint(u32 versionMajor, u32 versionMinor) -> void {
 auto KeyboardCallback(GLFWwindow* window, int key, int scancode, int action, int mods) -> void {
     using platform::input::KeyCode;
     auto* windowState = GetWindowState(window);
-    printf("@ %d %d", key, scancode);
-    auto keyCode = static_cast<KeyCode>(key);
-    auto keyName = glfwGetKeyName(key, scancode);
-    auto modifierKeysState = platform::input::ModifierKeysState{};
-    if (mods & GLFW_MOD_CONTROL) {
-        modifierKeysState |= platform::input::MODIFIERS_CTRL;
-    }
-    if (mods & GLFW_MOD_SHIFT) {
-        modifierKeysState |= platform::input::MODIFIERS_SHIFT;
-    }
-    if (mods & GLFW_MOD_ALT) {
-        modifierKeysState |= platform::input::MODIFIERS_ALT;
-    }
-    auto foundAction = windowState->KeyMap.find({keyCode, modifierKeysState});
-    if (foundAction == windowState->KeyMap.end()) {
-        // fallback to default if present
-        foundAction = windowState->KeyMap.find({
-            platform::input::KeyCode::ANYTHING,
-            platform::input::MODIFIERS_NONE,
-        });
-    }
-    if (foundAction == windowState->KeyMap.end()) {
-        return;
-    }
-    foundAction->second.operator()(
-        keyCode,
-        static_cast<platform::input::KeyState>(action),
-        keyName
-    );
+    auto inputEvent = ::MakeInputEvent(InputEventType::KEY, key, action, mods, static_cast<f64>(scancode));
+    if (::BeginInputEvent(windowState, inputEvent) == false) {
+        return;
+    }
+    if (key >= 0 && key < static_cast<int>(platform::input::KEY_CODE_COUNT) && action != GLFW_REPEAT) {
+        platform::input::InputStateSetBit(windowState->InputState,
+            platform::input::InputBitIndex(static_cast<KeyCode>(key)), action == GLFW_PRESS);
+    }
+    if (::PushInputEvent(windowState, inputEvent)) {
+        return;
+    }
+    DEI_LOG_TRACE("Key %d scancode %d\n", key, scancode);
+    const auto* keyAction = windowState->KeyMap.Find(key, static_cast<u32>(mods));
+    if (keyAction == nullptr) {
+        return;
+    }
+    (*keyAction)(static_cast<KeyCode>(key), static_cast<platform::input::KeyState>(action), glfwGetKeyName(key, scancode));
 }
 
 auto TextInputCallback(GLFWwindow* window, u32 codepoint) {
     auto* windowState = GetWindowState(window);
-    auto isAppended = dei::platform::AppendToUtf8{}(windowState->InputTextUtf8, codepoint);
-    if (!isAppended || windowState->InputTextCallback == nullptr) {
+    auto inputEvent = ::MakeInputEvent(InputEventType::TEXT, static_cast<i32>(codepoint));
+    if (::BeginInputEvent(windowState, inputEvent) == false) {
+        return;
+    }
+    if (::PushInputEvent(windowState, inputEvent)) {
+        return;
+    }
+    auto edit = platform::input::TextBufferInsertCodepoint(windowState->InputText, codepoint);
+    if (edit == std::nullopt) {
         return;
     }
-    windowState->InputTextCallback(windowState->InputTextUtf8, codepoint);
+    ::NotifyTextEdit(windowState, *edit);
 }
 
 auto MousePositionCallback(GLFWwindow* window, double windowX, double windowY) {
     auto* windowState = GetWindowState(window);
+    auto inputEvent = ::MakeInputEvent(InputEventType::MOUSE_POSITION, 0, 0, 0, windowX, windowY);
+    if (::BeginInputEvent(windowState, inputEvent) == false) {
+        return;
+    }
+    platform::input::MouseMotionAddPosition(windowState->MouseMotion, windowX, windowY);
+    if (::PushInputEvent(windowState, inputEvent)) {
+        return;
+    }
     if (windowState->MousePositionCallback == nullptr) {
         return;
     }
@@ -90,6 +162,14 @@ auto MousePositionCallback(GLFWwindow* window, double windowX, double windowY) {
 
 auto MouseScrollCallback(GLFWwindow* window, double directionX, double directionY) {
     auto* windowState = GetWindowState(window);
+    auto inputEvent = ::MakeInputEvent(InputEventType::MOUSE_SCROLL, 0, 0, 0, directionX, directionY);
+    if (::BeginInputEvent(windowState, inputEvent) == false) {
+        return;
+    }
+    platform::input::MouseMotionAddScroll(windowState->MouseMotion, directionX, directionY);
+    if (::PushInputEvent(windowState, inputEvent)) {
+        return;
+    }
     if (windowState->MouseScrollCallback == nullptr) {
         return;
     }
@@ -99,6 +179,17 @@ auto MouseScrollCallback(GLFWwindow* window, double directionX, double direction
 auto MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
     (void)mods;
     auto* windowState = GetWindowState(window);
+    auto inputEvent = ::MakeInputEvent(InputEventType::MOUSE_BUTTON, button, action, mods);
+    if (::BeginInputEvent(windowState, inputEvent) == false) {
+        return;
+    }
+    if (button >= 0 && button < static_cast<int>(platform::input::MouseButton::_MAX_BUTTONS)) {
+        platform::input::InputStateSetBit(windowState->InputState,
+            platform::input::InputBitIndex(static_cast<platform::input::MouseButton>(button)), action == GLFW_PRESS);
+    }
+    if (::PushInputEvent(windowState, inputEvent)) {
+        return;
+    }
     if (windowState->MouseButtonCallback == nullptr) {
         return;
     }
@@ -110,6 +201,13 @@ auto MouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
 
 auto MouseEntersWindowCallback(GLFWwindow* window, int entered) {
     auto* windowState = GetWindowState(window);
+    auto inputEvent = ::MakeInputEvent(InputEventType::MOUSE_ENTERS, entered);
+    if (::BeginInputEvent(windowState, inputEvent) == false) {
+        return;
+    }
+    if (::PushInputEvent(windowState, inputEvent)) {
+        return;
+    }
     if (windowState->MouseEntersWindowCallback == nullptr) {
         return;
     }
@@ -118,15 +216,39 @@ auto MouseEntersWindowCallback(GLFWwindow* window, int entered) {
 
 auto WindowPositionCallback(GLFWwindow* window, int leftUpCornerX, int leftUpCornerY) {
     auto* windowState = GetWindowState(window);
+    auto inputEvent = ::MakeInputEvent(InputEventType::WINDOW_POSITION, 0, 0, 0, leftUpCornerX, leftUpCornerY);
+    if (::BeginInputEvent(windowState, inputEvent) == false) {
+        return;
+    }
+    if (::PushInputEvent(windowState, inputEvent)) {
+        return;
+    }
     if (windowState->MouseEntersWindowCallback == nullptr) {
         return;
     }
     windowState->WindowPositionCallback(leftUpCornerX, leftUpCornerY);
 }
 
+inline auto SetSurfaceSize(WindowState* windowState, int widthPx, int heightPx) -> void {
+    auto& surface = windowState->SurfaceState;
+    surface.FramebufferSizePx.store(
+        (static_cast<u64>(widthPx) << 32) | static_cast<u32>(heightPx), std::memory_order_relaxed);
+    surface.LastResizeNanosec.store(platform::GetMonotonicNanosec(), std::memory_order_relaxed);
+    surface.NumResizes.fetch_add(1, std::memory_order_release);
+}
+
 auto WindowResizeCallback(GLFWwindow* window, int widthPx, int heightPx) {
     auto* windowState = GetWindowState(window);
-    if (windowState->MouseEntersWindowCallback == nullptr) {
+    // the swapchain follows the real framebuffer, even while replaying recorded input
+    ::SetSurfaceSize(windowState, widthPx, heightPx);
+    auto inputEvent = ::MakeInputEvent(InputEventType::WINDOW_RESIZE, 0, 0, 0, widthPx, heightPx);
+    if (::BeginInputEvent(windowState, inputEvent) == false) {
+        return;
+    }
+    if (::PushInputEvent(windowState, inputEvent)) {
+        return;
+    }
+    if (windowState->WindowResizeCallback == nullptr) {
         return;
     }
     windowState->WindowResizeCallback(widthPx, heightPx);
@@ -134,6 +256,13 @@ auto WindowResizeCallback(GLFWwindow* window, int widthPx, int heightPx) {
 
 auto WindowClosingCallback(GLFWwindow* window) {
     auto* windowState = GetWindowState(window);
+    auto inputEvent = ::MakeInputEvent(InputEventType::WINDOW_CLOSING, 0);
+    if (::BeginInputEvent(windowState, inputEvent) == false) {
+        return;
+    }
+    if (::PushInputEvent(windowState, inputEvent)) {
+        return;
+    }
     if (windowState->WindowClosingCallback == nullptr) {
         return;
     }
@@ -142,12 +271,59 @@ auto WindowClosingCallback(GLFWwindow* window) {
 
 auto WindowFocusedCallback(GLFWwindow* window, int isFocused) {
     auto* windowState = GetWindowState(window);
+    auto inputEvent = ::MakeInputEvent(InputEventType::WINDOW_FOCUS, isFocused);
+    if (::BeginInputEvent(windowState, inputEvent) == false) {
+        return;
+    }
+    if (::PushInputEvent(windowState, inputEvent)) {
+        return;
+    }
     if (windowState->WindowFocusedCallback == nullptr) {
         return;
     }
     windowState->WindowFocusedCallback(isFocused != 0);
 }
 
+// replays a recorded event through the same callback GLFW would call
+auto DispatchRecordedInputEvent(GLFWwindow* window, const platform::input::InputEvent& event) -> void {
+    auto x = static_cast<int>(event.X);
+    auto y = static_cast<int>(event.Y);
+    switch (event.Type) {
+        case InputEventType::KEY:
+            ::KeyboardCallback(window, event.Code, x, event.Action, event.Modifiers);
+            break;
+        case InputEventType::TEXT:
+            ::TextInputCallback(window, static_cast<u32>(event.Code));
+            break;
+        case InputEventType::MOUSE_POSITION:
+            ::MousePositionCallback(window, event.X, event.Y);
+            break;
+        case InputEventType::MOUSE_SCROLL:
+            ::MouseScrollCallback(window, event.X, event.Y);
+            break;
+        case InputEventType::MOUSE_BUTTON:
+            ::MouseButtonCallback(window, event.Code, event.Action, event.Modifiers);
+            break;
+        case InputEventType::MOUSE_ENTERS:
+            ::MouseEntersWindowCallback(window, event.Code);
+            break;
+        case InputEventType::WINDOW_POSITION:
+            ::WindowPositionCallback(window, x, y);
+            break;
+        case InputEventType::WINDOW_RESIZE:
+            ::WindowResizeCallback(window, x, y);
+            break;
+        case InputEventType::WINDOW_CLOSING:
+            ::WindowClosingCallback(window);
+            break;
+        case InputEventType::WINDOW_FOCUS:
+            ::WindowFocusedCallback(window, event.Code);
+            break;
+        case InputEventType::FRAME_BEGIN:
+            break;
+    }
+}
+
 } // namespace
 
 namespace dei::platform {
@@ -163,15 +339,32 @@ auto CreateWindowSystem(void (*errorCallback)(int, const char*)) -> WindowSystem
 }
 
 auto PollWindowEvents(const WindowSystemHandle&) -> void {
+    DEI_PROFILE_SCOPE("PollWindowEvents");
+    auto allocationTag = AllocationTagScope{AllocationTag::WINDOW};
     glfwPollEvents();
 }
 
+auto WaitWindowEvents(const WindowSystemHandle&, f64 timeoutSec) -> void {
+    DEI_PROFILE_SCOPE("WaitWindowEvents");
+    auto allocationTag = AllocationTagScope{AllocationTag::WINDOW};
+    glfwWaitEventsTimeout(timeoutSec);
+}
+
+auto WakeWindowEvents(const WindowSystemHandle&) -> void {
+    glfwPostEmptyEvent();
+}
+
 auto GetKeyName(const WindowSystemHandle&, input::KeyCode key) -> const char* {
     return glfwGetKeyName(static_cast<int>(key), 0);
 }
 
 auto GetClipboardUtf8(const WindowSystemHandle&) -> const char * {
-    return glfwGetClipboardString(nullptr);
+    const auto* clipboardUtf8 = glfwGetClipboardString(nullptr);
+    // other applications may put anything there
+    if (clipboardUtf8 == nullptr || !Utf8Validate(clipboardUtf8, std::strlen(clipboardUtf8))) {
+        return nullptr;
+    }
+    return clipboardUtf8;
 }
 
 auto SetClipboardUtf8(const WindowSystemHandle&, const char* textUtff8) -> void {
@@ -188,6 +381,8 @@ auto WindowDestroyer::operator()(GLFWwindow* window) -> void {
     }
     auto* windowState = static_cast<WindowState*>(glfwGetWindowUserPointer(window));
     if (windowState != nullptr) {
+        platform::input::InputRecordingClose(windowState->Recording);
+        delete windowState->InputEvents;
         delete windowState;
     }
     glfwDestroyWindow(window);
@@ -331,6 +526,11 @@ auto WindowBuilder::WithMouseScrollCallback(input::MouseScrollCallback callback)
     return *this;
 }
 
+auto WindowBuilder::WithBufferedInput(b8 isInputBuffered) -> WindowBuilder& {
+    _args.IsInputBuffered = isInputBuffered;
+    return *this;
+}
+
 auto WindowBuilder::WithMouseEntersWindowCallback(input::MouseEntersWindowCallback callback) -> WindowBuilder& {
     _args.MouseEntersWindowCallback = callback;
     return *this;
@@ -453,12 +653,12 @@ auto CreateWindow(const WindowSystemHandle& windowSystem, CreateWindowArgs&& arg
     windowState->WindowResizeCallback = std::move(args.WindowResizeCallback);
     windowState->WindowClosingCallback = std::move(args.WindowClosingCallback);
     windowState->WindowFocusedCallback = std::move(args.WindowFocusedCallback);
-    windowState->InputTextUtf8 = std::string{};
     windowState->InputTextCallback = std::move(args.InputTextCallback);
     windowState->MousePositionCallback = std::move(args.MousePositionCallback);
     windowState->MouseButtonCallback = std::move(args.MouseButtonCallback);
     windowState->MouseScrollCallback = std::move(args.MouseScrollCallback);
     windowState->MouseEntersWindowCallback = std::move(args.MouseEntersWindowCallback);
+    windowState->InputEvents = args.IsInputBuffered ? new platform::input::InputEventQueue{} : nullptr;
 
     glfwDefaultWindowHints();
     switch (args.GraphicsApi) {
@@ -540,6 +740,10 @@ auto CreateWindow(const WindowSystemHandle& windowSystem, CreateWindowArgs&& arg
         static_cast<int>(args.Size.y), 
         args.TitleUtf8, args.Monitor, nullptr);
     glfwSetWindowUserPointer(window, windowState);
+    windowState->SurfaceState.Present.store(PresentPolicy::VSYNC, std::memory_order_relaxed);
+    auto framebufferSize = vec2i{};
+    glfwGetFramebufferSize(window, &framebufferSize.x, &framebufferSize.y);
+    ::SetSurfaceSize(windowState, framebufferSize.x, framebufferSize.y);
     glfwSetKeyCallback(window, &::KeyboardCallback);
     glfwSetCharCallback(window, &::TextInputCallback);
     glfwSetCursorPosCallback(window, &::MousePositionCallback);
@@ -577,17 +781,120 @@ auto WindowIsClosing(const WindowHandle& window) -> b8 {
     return glfwWindowShouldClose(window.get());
 }
 
+auto WindowLatchInputState(const WindowHandle& window) -> void {
+    auto* windowState = GetWindowState(window);
+    platform::input::InputStateLatch(windowState->InputState, windowState->InputSnapshot);
+}
+
+auto WindowTakeInputTimestamp(const WindowHandle& window) -> i64 {
+    return GetWindowState(window)->EarliestInputNanosec.exchange(0, std::memory_order_relaxed);
+}
+
+auto WindowBeginInputFrame(const WindowHandle& window) -> b8 {
+    auto* windowState = GetWindowState(window);
+    auto& recording = windowState->Recording;
+    auto frameIndex = windowState->InputFrameIndex++;
+    auto nowNanosec = GetMonotonicNanosec();
+    if (!recording.IsReplaying) {
+        windowState->FrameNanosec = nowNanosec;
+        input::InputRecordingWriteFrame(recording, frameIndex, nowNanosec);
+        return false;
+    }
+    windowState->IsDispatchingReplay = true;
+    auto hasMoreFrames = input::InputRecordingReplayFrame(recording, frameIndex, [&](const input::InputEvent& event) {
+        ::DispatchRecordedInputEvent(window.get(), event);
+    });
+    windowState->IsDispatchingReplay = false;
+    windowState->FrameNanosec = recording.FrameNanosec != 0
+        ? recording.FrameNanosec + windowState->ReplayClockOffsetNanosec
+        : nowNanosec;
+    if (!hasMoreFrames) {
+        DEI_LOG_INFO("InputRecording: replayed %lu events in %lu frames\n", recording.NumRecords, frameIndex + 1);
+        input::InputRecordingClose(recording);
+    }
+    return true;
+}
+
+auto WindowStartInputRecording(const WindowHandle& window, const char* filepath) -> b8 {
+    auto* windowState = GetWindowState(window);
+    windowState->InputFrameIndex = 0;
+    return input::InputRecordingOpenWrite(windowState->Recording, filepath);
+}
+
+auto WindowStartInputReplay(const WindowHandle& window, const char* filepath) -> b8 {
+    auto* windowState = GetWindowState(window);
+    windowState->InputFrameIndex = 0;
+    if (!input::InputRecordingOpenRead(windowState->Recording, filepath)) {
+        return false;
+    }
+    const auto& recording = windowState->Recording;
+    windowState->ReplayClockOffsetNanosec = recording.HasNextRecord
+        ? GetMonotonicNanosec() - recording.NextRecord.Event.TimestampNanosec
+        : 0;
+    return true;
+}
+
+auto WindowStartInputRecordingFromEnvironment(const WindowHandle& window) -> b8 {
+    if (const auto* replayFilepath = std::getenv("DEI_INPUT_REPLAY"); replayFilepath != nullptr) {
+        return WindowStartInputReplay(window, replayFilepath);
+    }
+    if (const auto* recordFilepath = std::getenv("DEI_INPUT_RECORD"); recordFilepath != nullptr) {
+        return WindowStartInputRecording(window, recordFilepath);
+    }
+    return false;
+}
+
+auto WindowStopInputRecording(const WindowHandle& window) -> void {
+    input::InputRecordingClose(GetWindowState(window)->Recording);
+}
+
+auto WindowIsReplayingInput(const WindowHandle& window) -> b8 {
+    return GetWindowState(window)->Recording.IsReplaying;
+}
+
+auto WindowGetFrameNanosec(const WindowHandle& window) -> const i64& {
+    return GetWindowState(window)->FrameNanosec;
+}
+
+auto WindowGetInputSnapshot(const WindowHandle& window) -> const input::InputSnapshot& {
+    return GetWindowState(window)->InputSnapshot;
+}
+
+auto WindowGetMouseMotion(const WindowHandle& window) -> input::MouseMotionAccumulator& {
+    return GetWindowState(window)->MouseMotion;
+}
+
+auto WindowGetInputEventQueue(const WindowHandle& window) -> input::InputEventQueue* {
+    return GetWindowState(window)->InputEvents;
+}
+
+auto WindowGetEventCount(const WindowHandle& window) -> u64 {
+    return GetWindowState(window)->NumEvents.load(std::memory_order_relaxed);
+}
+
 auto WindowGetSize(const WindowHandle& window) -> vec2i {
     auto size = vec2i{};
     glfwGetWindowSize(window.get(), &size.x, &size.y);
     return size;
 }
 
+auto WindowGetSurfaceState(const WindowHandle& window) -> WindowSurfaceState& {
+    return GetWindowState(window)->SurfaceState;
+}
+
+auto WindowSetPresentPolicy(const WindowHandle& window, PresentPolicy policy) -> void {
+    GetWindowState(window)->SurfaceState.Present.store(policy, std::memory_order_relaxed);
+}
+
 auto WindowSetSize(const WindowHandle& window, vec2i size) -> void {
     glfwSetWindowSize(window.get(), size.x, size.y);
 }
 
 auto WindowSetTitleUtf8(const WindowHandle& window, const char* titleUtf8) -> void {
+    if (!Utf8Validate(titleUtf8, std::strlen(titleUtf8))) {
+        DEI_LOG_WARN("WindowSetTitleUtf8: the title isn't valid UTF-8\n");
+        return;
+    }
     glfwSetWindowTitle(window.get(), titleUtf8);
 }
 
@@ -596,6 +903,7 @@ auto WindowSetKeyMap(const WindowHandle& window, platform::input::KeyMap&& keyma
 }
 
 auto WindowSwapBuffers(const WindowHandle& window) -> void {
+    DEI_PROFILE_SCOPE("WindowSwapBuffers");
     if (GetWindowState(window)->HasContextObject == false) {
         return;
     }
@@ -603,19 +911,38 @@ auto WindowSwapBuffers(const WindowHandle& window) -> void {
 }
 
 auto WindowAppendInputUtf8(const WindowHandle& window, const char* textUtf8) -> void {
-    GetWindowState(window)->InputTextUtf8.append(textUtf8);
+    if (textUtf8 == nullptr) {
+        return;
+    }
+    auto text = std::string_view{textUtf8};
+    if (!Utf8Validate(text)) {
+        return;
+    }
+    auto* windowState = GetWindowState(window);
+    ::NotifyTextEdit(windowState, input::TextBufferInsert(windowState->InputText, text));
+}
+
+auto WindowEraseInput(const WindowHandle& window, u32 numCodepoints) -> void {
+    auto* windowState = GetWindowState(window);
+    ::NotifyTextEdit(windowState, input::TextBufferErase(windowState->InputText, numCodepoints));
 }
 
 auto WindowClearInput(const WindowHandle& window) -> void {
-    GetWindowState(window)->InputTextUtf8.clear();
+    auto* windowState = GetWindowState(window);
+    ::NotifyTextEdit(windowState, input::TextBufferClear(windowState->InputText));
 }
 
 auto WindowUndoInput(const WindowHandle& window) -> void {
     auto* windowState = GetWindowState(window);
-    if (windowState->InputTextUtf8.size() == 0) {
+    auto edit = input::TextBufferUndo(windowState->InputText);
+    if (edit == std::nullopt) {
         return;
     }
-    windowState->InputTextUtf8.resize(windowState->InputTextUtf8.size() - 1);
+    ::NotifyTextEdit(windowState, *edit);
+}
+
+auto WindowGetInputText(const WindowHandle& window) -> const input::TextBuffer& {
+    return GetWindowState(window)->InputText;
 }
 
 auto WindowGetMousePosition(const WindowHandle& window) -> vec2ff {
@@ -664,7 +991,7 @@ auto WindowInitializeVulkanBackend(const WindowHandle& window, VkInstance vkInst
         return std::nullopt;
     }
     VkSurfaceKHR surface;
-    VkResult status = glfwCreateWindowSurface(vkInstance, window.get(), nullptr, &surface);
+    VkResult status = glfwCreateWindowSurface(vkInstance, window.get(), GetVulkanAllocationCallbacks(), &surface);
     if (status != VK_SUCCESS) {
         return std::nullopt;
     }
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Prelude.hpp"
+
+#include <cstddef>
+
+namespace dei::platform {
+
+// Counts heap allocations done with the global operator new. The counting only works
+// in executables that replace operator new with calls to AllocationOnNew/AllocationOnDelete
+// (editor/AllocationHooks.cpp), otherwise all counters stay zero
+
+enum class AllocationTag : u32 {
+   UNTAGGED,
+   HOST,
+   WINDOW,
+   ENGINE,
+   RENDER,
+   PROFILER,
+   LOG,
+   VULKAN,
+   _COUNT,
+};
+
+constexpr u32 ALLOCATION_TAG_COUNT = static_cast<u32>(AllocationTag::_COUNT);
+
+constexpr const char* AllocationTagToStr(AllocationTag tag) {
+   switch (tag) {
+      case AllocationTag::UNTAGGED: return "UNTAGGED";
+      case AllocationTag::HOST: return "HOST";
+      case AllocationTag::WINDOW: return "WINDOW";
+      case AllocationTag::ENGINE: return "ENGINE";
+      case AllocationTag::RENDER: return "RENDER";
+      case AllocationTag::PROFILER: return "PROFILER";
+      case AllocationTag::LOG: return "LOG";
+      case AllocationTag::VULKAN: return "VULKAN";
+      case AllocationTag::_COUNT: break;
+   }
+   return "UNKNOWN";
+}
+
+struct AllocationStats {
+   u64 NumAllocations;
+   u64 NumFrees;
+   u64 NumBytes;
+};
+
+// called by the replaced operator new/delete only, AllocationOnNew returns the tag the block is counted under,
+// the block must keep it and pass it back to AllocationOnDelete, so frees on other threads or under
+// another tag are attributed to the tag of the allocation
+auto AllocationOnNew(size_t numBytes) -> AllocationTag;
+auto AllocationOnDelete(AllocationTag) -> void;
+
+auto AllocationQuery(AllocationTag) -> AllocationStats;
+// over all tags, cheap enough to call every frame
+auto AllocationGetTotalCount() -> u64;
+auto PrintAllocationStats() -> void;
+
+// allocations of this thread are attributed to the tag, returns the previous one
+auto AllocationSetTag(AllocationTag) -> AllocationTag;
+
+struct AllocationTagScope {
+   explicit AllocationTagScope(AllocationTag tag) : _previous(AllocationSetTag(tag)) {}
+   ~AllocationTagScope() { AllocationSetTag(_previous); }
+   AllocationTagScope(const AllocationTagScope&) = delete;
+   auto operator=(const AllocationTagScope&) -> AllocationTagScope& = delete;
+private:
+   AllocationTag _previous;
+};
+
+// What happens on an allocation inside an active AllocationGuardScope
+enum class AllocationGuardMode : u32 {
+   OFF,
+   // print the backtrace (the first few times only)
+   LOG,
+   // print the backtrace and abort
+   ABORT,
+};
+
+auto AllocationGuardSetMode(AllocationGuardMode) -> void;
+// from DEI_ALLOCATION_GUARD environment variable: "log" or "abort", OFF otherwise
+auto AllocationGuardModeFromEnvironment() -> AllocationGuardMode;
+auto AllocationGuardGetViolationCount() -> u64;
+
+// marks code of this thread that must not allocate, e.g. a steady state engine tick
+struct AllocationGuardScope {
+   explicit AllocationGuardScope(b8 isActive);
+   ~AllocationGuardScope();
+   AllocationGuardScope(const AllocationGuardScope&) = delete;
+   auto operator=(const AllocationGuardScope&) -> AllocationGuardScope& = delete;
+private:
+   b8 _isActive;
+};
+
+}
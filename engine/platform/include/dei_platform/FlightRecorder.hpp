@@ -0,0 +1,85 @@
+#pragma once
+
+#include "Prelude.hpp"
+#include "FrameStats.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace dei::platform {
+
+// number of latest frames kept, a few seconds at usual frame rates
+constexpr u32 FLIGHT_RECORDER_CAPACITY = 1024;
+
+struct FlightRecord {
+   u64 FrameIndex;
+   i64 FrameBeginNanosec;
+   f32 PhaseMs[FRAME_PHASE_COUNT];
+   u32 NumEvents;
+   u32 NumSimulationSteps;
+   u32 NumAllocations;
+   u32 HotReloadVersion;
+   i32 HotReloadFailure;
+   i32 HotReloadAnswer;
+};
+
+// Always-on record of the latest frames. When a frame takes longer than BudgetMs,
+// the whole window is written to DumpDirectory as JSON (at most once per cooldown).
+// The frame thread only copies the window, a writer thread formats and writes the file
+struct FlightRecorder {
+   FlightRecord Records[FLIGHT_RECORDER_CAPACITY];
+   u64 NumFrames;
+   f32 BudgetMs; // 0 - never dump
+   i64 CooldownNanosec;
+   i64 LastDumpNanosec;
+   u32 NumDumps;
+   // hitches while the previous dump was still being written
+   u32 NumSkippedDumps;
+   std::string DumpDirectory;
+   // the window at the hitch, owned by the writer thread while IsDumpPending
+   FlightRecord Snapshot[FLIGHT_RECORDER_CAPACITY];
+   u64 SnapshotNumFrames;
+   u32 SnapshotDumpIndex;
+   std::atomic<b8> IsDumpPending;
+   std::atomic<b8> IsRunning;
+   std::mutex Mutex;
+   std::condition_variable DumpRequested;
+   std::thread Writer;
+};
+
+// starts the writer thread
+auto FlightRecorderConfigure(FlightRecorder&, const char* dumpDirectory, f32 budgetMs, f64 cooldownSec = 5.0) -> void;
+// writes the pending dump, if any, and joins the writer thread
+auto FlightRecorderStop(FlightRecorder&) -> void;
+// the cold path, copies the window for the writer thread, returns true if a dump was queued
+auto FlightRecorderDump(FlightRecorder&) -> b8;
+
+// call after FrameStatsEndFrame, phase times are taken from the latest samples,
+// the caller fills in the rest of the returned record
+inline auto FlightRecorderRecordFrame(FlightRecorder& recorder, const FrameStats& stats) -> FlightRecord& {
+   auto& record = recorder.Records[recorder.NumFrames % FLIGHT_RECORDER_CAPACITY];
+   record = FlightRecord{};
+   record.FrameIndex = recorder.NumFrames;
+   record.FrameBeginNanosec = stats.FrameBeginNanosec;
+   for (u32 phase = 0; phase < FRAME_PHASE_COUNT; ++phase) {
+      record.PhaseMs[phase] = FrameStatsLastMs(stats, static_cast<FramePhase>(phase));
+   }
+   return record;
+}
+
+// returns true if the frame was over budget and a dump of the recording was queued
+inline auto FlightRecorderEndFrame(FlightRecorder& recorder) -> b8 {
+   const auto& record = recorder.Records[recorder.NumFrames % FLIGHT_RECORDER_CAPACITY];
+   ++recorder.NumFrames;
+   auto frameMs = record.PhaseMs[static_cast<u32>(FramePhase::FRAME_TOTAL)];
+   // the first frame includes the engine startup
+   if (recorder.BudgetMs <= 0.0f || frameMs <= recorder.BudgetMs || record.FrameIndex == 0) {
+      return false;
+   }
+   return FlightRecorderDump(recorder);
+}
+
+}
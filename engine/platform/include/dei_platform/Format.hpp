@@ -0,0 +1,238 @@
+#pragma once
+
+#include "Prelude.hpp"
+
+#include <charconv>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Wraps a string literal so that FormatTo parses it at compile time, e.g.
+// FormatTo(title, DEI_FORMAT("frame={} time={:.1}s"), drawCounter, timeSec);
+// Placeholders: {} any argument, {:x} integer in hex, {:.N} float with N digits after the point (N <= 9),
+// {{ and }} are the braces themselves
+#define DEI_FORMAT(format) \
+   [] { \
+      struct DeiFormat { \
+         static constexpr auto Get() -> std::string_view { return format; } \
+      }; \
+      return DeiFormat{}; \
+   }()
+
+namespace dei::platform {
+
+// a window into caller-provided memory, never allocates
+struct FormatOutput {
+   char* Data;
+   u32 Capacity; // bytes, not counting the null terminator
+   u32 Size;
+   b8 IsTruncated;
+};
+
+template<u32 CAPACITY>
+struct FixedString {
+   static_assert(CAPACITY > 0);
+   char Data[CAPACITY]{};
+   u32 Size{0};
+
+   auto CStr() const -> const char* { return Data; }
+   auto View() const -> std::string_view { return std::string_view{Data, Size}; }
+};
+
+// the text is cut before a UTF-8 sequence which doesn't fit
+inline auto FormatPut(FormatOutput& output, const char* text, size_t numBytes) -> void {
+   auto numFree = static_cast<size_t>(output.Capacity - output.Size);
+   if (numBytes > numFree) {
+      numBytes = numFree;
+      while (numBytes > 0 && (static_cast<u8>(text[numBytes]) & 0xC0) == 0x80) {
+         --numBytes;
+      }
+      output.IsTruncated = true;
+   }
+   std::memcpy(output.Data + output.Size, text, numBytes);
+   output.Size += static_cast<u32>(numBytes);
+}
+
+inline auto FormatPut(FormatOutput& output, char symbol) -> void {
+   if (output.Size < output.Capacity) {
+      output.Data[output.Size++] = symbol;
+   } else {
+      output.IsTruncated = true;
+   }
+}
+
+// fixed notation, rounded half up, values past 1e18 are written in exponent notation
+auto FormatPutF64(FormatOutput&, f64 value, u32 precision) -> void;
+
+namespace internal {
+
+constexpr u8 FORMAT_DEFAULT_PRECISION = 0xFF;
+
+// literal text followed by an argument, unless it's the last segment or the text ends with an escaped brace
+struct FormatSegment {
+   u32 LiteralBegin;
+   u32 LiteralSize;
+   b8 HasArgument;
+   b8 IsHex;
+   u8 Precision;
+};
+
+template<size_t MAX_SEGMENTS>
+struct FormatSpec {
+   FormatSegment Segments[MAX_SEGMENTS]{};
+   u32 NumSegments = 0;
+   u32 NumArguments = 0;
+   b8 IsValid = true;
+};
+
+template<size_t MAX_SEGMENTS>
+constexpr auto ParseFormat(std::string_view format) -> FormatSpec<MAX_SEGMENTS> {
+   auto spec = FormatSpec<MAX_SEGMENTS>{};
+   auto segment = FormatSegment{ 0, 0, false, false, FORMAT_DEFAULT_PRECISION };
+   size_t i = 0;
+   while (i < format.size()) {
+      auto symbol = format[i];
+      if ((symbol == '{' || symbol == '}') && i + 1 < format.size() && format[i + 1] == symbol) {
+         // the first brace of the pair ends the literal, the next segment starts after the pair
+         ++segment.LiteralSize;
+         i += 2;
+         spec.Segments[spec.NumSegments++] = segment;
+         segment = FormatSegment{ static_cast<u32>(i), 0, false, false, FORMAT_DEFAULT_PRECISION };
+         continue;
+      }
+      if (symbol == '}') {
+         spec.IsValid = false;
+         return spec;
+      }
+      if (symbol != '{') {
+         ++segment.LiteralSize;
+         ++i;
+         continue;
+      }
+      // placeholder
+      ++i;
+      if (i < format.size() && format[i] == ':') {
+         ++i;
+         if (i < format.size() && format[i] == 'x') {
+            segment.IsHex = true;
+            ++i;
+         } else if (i + 1 < format.size() && format[i] == '.' && format[i + 1] >= '0' && format[i + 1] <= '9') {
+            segment.Precision = static_cast<u8>(format[i + 1] - '0');
+            i += 2;
+         } else {
+            spec.IsValid = false;
+            return spec;
+         }
+      }
+      if (i >= format.size() || format[i] != '}') {
+         spec.IsValid = false;
+         return spec;
+      }
+      ++i;
+      segment.HasArgument = true;
+      ++spec.NumArguments;
+      spec.Segments[spec.NumSegments++] = segment;
+      segment = FormatSegment{ static_cast<u32>(i), 0, false, false, FORMAT_DEFAULT_PRECISION };
+   }
+   spec.Segments[spec.NumSegments++] = segment;
+   return spec;
+}
+
+template<typename T>
+constexpr b8 IS_FORMAT_STRING = std::is_convertible_v<const T&, std::string_view>;
+
+template<typename T>
+auto FormatPutValue(FormatOutput& output, const T& value, const FormatSegment& segment) -> void {
+   if constexpr (IS_FORMAT_STRING<T>) {
+      auto text = std::string_view{value};
+      FormatPut(output, text.data(), text.size());
+   } else if constexpr (std::is_same_v<T, char>) {
+      FormatPut(output, value);
+   } else if constexpr (std::is_same_v<T, bool>) {
+      value ? FormatPut(output, "true", 4) : FormatPut(output, "false", 5);
+   } else if constexpr (std::is_enum_v<T>) {
+      FormatPutValue(output, static_cast<std::underlying_type_t<T>>(value), segment);
+   } else if constexpr (std::is_integral_v<T>) {
+      char buffer[24];
+      auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, segment.IsHex ? 16 : 10);
+      FormatPut(output, buffer, static_cast<size_t>(result.ptr - buffer));
+   } else if constexpr (std::is_floating_point_v<T>) {
+      FormatPutF64(output, static_cast<f64>(value),
+         segment.Precision == FORMAT_DEFAULT_PRECISION ? 6 : segment.Precision);
+   } else if constexpr (std::is_pointer_v<T>) {
+      char buffer[24] = { '0', 'x' };
+      auto result = std::to_chars(buffer + 2, buffer + sizeof(buffer), reinterpret_cast<uintptr_t>(value), 16);
+      FormatPut(output, buffer, static_cast<size_t>(result.ptr - buffer));
+   } else {
+      static_assert(sizeof(T) == 0, "the type can't be formatted");
+   }
+}
+
+// writes the literal text up to the next argument, returns the segment of that argument
+template<size_t MAX_SEGMENTS>
+auto FormatPutLiterals(FormatOutput& output, std::string_view format, const FormatSpec<MAX_SEGMENTS>& spec, u32& segmentIndex)
+   -> const FormatSegment& {
+   while (true) {
+      const auto& segment = spec.Segments[segmentIndex++];
+      FormatPut(output, format.data() + segment.LiteralBegin, segment.LiteralSize);
+      if (segment.HasArgument || segmentIndex == spec.NumSegments) {
+         return segment;
+      }
+   }
+}
+
+} // namespace internal
+
+// appends to the output, the format string comes from DEI_FORMAT
+template<typename Format, typename... Args>
+auto FormatTo(FormatOutput& output, Format, const Args&... args) -> void {
+   constexpr auto format = Format::Get();
+   // escapes and placeholders take at least 2 bytes, each ends a segment
+   static constexpr auto spec = internal::ParseFormat<format.size() / 2 + 1>(format);
+   static_assert(spec.IsValid, "unmatched brace or unknown placeholder in the format string");
+   static_assert(spec.NumArguments == sizeof...(Args), "the number of placeholders doesn't match the number of arguments");
+   u32 segmentIndex = 0;
+   (internal::FormatPutValue(output, args, internal::FormatPutLiterals(output, format, spec, segmentIndex)), ...);
+   if (segmentIndex < spec.NumSegments) {
+      internal::FormatPutLiterals(output, format, spec, segmentIndex);
+   }
+}
+
+// replaces the contents, returns false if the text was truncated
+template<u32 CAPACITY, typename Format, typename... Args>
+auto FormatTo(FixedString<CAPACITY>& destination, Format format, const Args&... args) -> b8 {
+   auto output = FormatOutput{ destination.Data, CAPACITY - 1, 0, false };
+   FormatTo(output, format, args...);
+   destination.Data[output.Size] = '\0';
+   destination.Size = output.Size;
+   return !output.IsTruncated;
+}
+
+// writes up to capacity - 1 bytes and the null terminator, returns the number of bytes before it
+template<typename Format, typename... Args>
+auto FormatTo(char* destination, u32 capacity, Format format, const Args&... args) -> u32 {
+   if (capacity == 0) {
+      return 0;
+   }
+   auto output = FormatOutput{ destination, capacity - 1, 0, false };
+   FormatTo(output, format, args...);
+   destination[output.Size] = '\0';
+   return output.Size;
+}
+
+// the text of one value without a format string, as StringJoin writes it
+template<typename T>
+auto FormatAppendValue(std::string& destination, const T& value) -> void {
+   if constexpr (internal::IS_FORMAT_STRING<T>) {
+      destination.append(std::string_view{value});
+   } else {
+      char buffer[64];
+      auto output = FormatOutput{ buffer, sizeof(buffer), 0, false };
+      internal::FormatPutValue(output, value,
+         internal::FormatSegment{ 0, 0, true, false, internal::FORMAT_DEFAULT_PRECISION });
+      destination.append(buffer, output.Size);
+   }
+}
+
+}
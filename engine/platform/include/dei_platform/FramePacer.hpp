@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Prelude.hpp"
+
+namespace dei::platform {
+
+struct FramePacerStats {
+   u64 NumFrames;
+   u64 NumMissedDeadlines;
+   // lateness of the wake up relative to the deadline (frames with missed deadline excluded)
+   f64 JitterMeanMicrosec;
+   f64 JitterStdDevMicrosec;
+   f64 JitterMaxMicrosec;
+   f64 SpinThresholdMicrosec;
+};
+
+// Sleeps until absolute deadlines spaced by 1/targetRate, the OS sleep wakes up
+// SpinThresholdNanosec before the deadline and the rest is busy-waited
+struct FramePacer {
+   i64 PeriodNanosec;
+   i64 NextDeadlineNanosec;
+   i64 SpinThresholdNanosec;
+   u64 NumFrames;
+   u64 NumMissedDeadlines;
+   u64 NumJitterSamples;
+   f64 JitterMeanNanosec;
+   f64 JitterM2Nanosec;
+   f64 JitterMaxNanosec;
+};
+
+auto CreateFramePacer(f64 targetRateHz) -> FramePacer;
+auto FramePacerSetTargetRate(FramePacer&, f64 targetRateHz) -> void;
+// returns false if the deadline was already missed when called (no waiting happens then)
+auto FramePacerWait(FramePacer&) -> b8;
+auto FramePacerGetStats(const FramePacer&) -> FramePacerStats;
+auto FramePacerResetStats(FramePacer&) -> void;
+
+}
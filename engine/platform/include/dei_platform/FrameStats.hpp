@@ -0,0 +1,94 @@
+#pragma once
+
+#include "Prelude.hpp"
+#include "Time.hpp"
+
+namespace dei::platform {
+
+enum class FramePhase : u32 {
+   POLL_EVENTS,
+   TITLE_UPDATE,
+   ENGINE_TICK,
+   SWAP_BUFFERS,
+   PACING_SLEEP,
+   FRAME_TOTAL,
+   // not a part of the frame: from the earliest input the frame reflects to its presentation,
+   // recorded only by frames with new input (see LatencyProbe)
+   INPUT_TO_PHOTON,
+   _COUNT,
+};
+
+constexpr u32 FRAME_PHASE_COUNT = static_cast<u32>(FramePhase::_COUNT);
+
+constexpr const char* FramePhaseToStr(FramePhase phase) {
+   switch (phase) {
+      case FramePhase::POLL_EVENTS: return "POLL_EVENTS";
+      case FramePhase::TITLE_UPDATE: return "TITLE_UPDATE";
+      case FramePhase::ENGINE_TICK: return "ENGINE_TICK";
+      case FramePhase::SWAP_BUFFERS: return "SWAP_BUFFERS";
+      case FramePhase::PACING_SLEEP: return "PACING_SLEEP";
+      case FramePhase::FRAME_TOTAL: return "FRAME_TOTAL";
+      case FramePhase::INPUT_TO_PHOTON: return "INPUT_TO_PHOTON";
+      case FramePhase::_COUNT: break;
+   }
+   return "UNKNOWN";
+}
+
+// number of latest samples kept per phase, percentiles are computed over this window
+constexpr u32 FRAME_STATS_WINDOW = 512;
+
+struct FramePhaseRing {
+   f32 SamplesMs[FRAME_STATS_WINDOW];
+   u32 NextIndex;
+   u32 NumSamples;
+};
+
+struct FramePhaseSummary {
+   f32 LastMs;
+   f32 P50Ms;
+   f32 P95Ms;
+   f32 P99Ms;
+   f32 MaxMs;
+   u32 NumSamples;
+};
+
+// fixed-size storage, recording never allocates
+struct FrameStats {
+   FramePhaseRing Phases[FRAME_PHASE_COUNT];
+   i64 FrameBeginNanosec;
+   i64 PhaseBeginNanosec;
+};
+
+inline auto FrameStatsRecord(FrameStats& stats, FramePhase phase, f32 durationMs) -> void {
+   auto& ring = stats.Phases[static_cast<u32>(phase)];
+   ring.SamplesMs[ring.NextIndex] = durationMs;
+   ring.NextIndex = (ring.NextIndex + 1) % FRAME_STATS_WINDOW;
+   ring.NumSamples += ring.NumSamples < FRAME_STATS_WINDOW;
+}
+
+inline auto FrameStatsLastMs(const FrameStats& stats, FramePhase phase) -> f32 {
+   const auto& ring = stats.Phases[static_cast<u32>(phase)];
+   return ring.SamplesMs[(ring.NextIndex + FRAME_STATS_WINDOW - 1) % FRAME_STATS_WINDOW];
+}
+
+inline auto FrameStatsBeginFrame(FrameStats& stats) -> void {
+   stats.FrameBeginNanosec = GetMonotonicNanosec();
+   stats.PhaseBeginNanosec = stats.FrameBeginNanosec;
+}
+
+// records time since the previous phase ended (or the frame began)
+inline auto FrameStatsEndPhase(FrameStats& stats, FramePhase phase) -> void {
+   auto now = GetMonotonicNanosec();
+   FrameStatsRecord(stats, phase, static_cast<f32>(now - stats.PhaseBeginNanosec) * 1e-6f);
+   stats.PhaseBeginNanosec = now;
+}
+
+inline auto FrameStatsEndFrame(FrameStats& stats) -> void {
+   auto now = GetMonotonicNanosec();
+   FrameStatsRecord(stats, FramePhase::FRAME_TOTAL, static_cast<f32>(now - stats.FrameBeginNanosec) * 1e-6f);
+}
+
+auto FrameStatsQuery(const FrameStats&, FramePhase) -> FramePhaseSummary;
+auto PrintFrameStats(const FrameStats&) -> void;
+
+}
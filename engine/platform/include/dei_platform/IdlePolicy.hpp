@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Prelude.hpp"
+#include "Window.hpp"
+
+namespace dei::platform {
+
+enum class IdleBehavior : u32 {
+   ALWAYS_RENDER,
+   // lower frame rate when unfocused, nothing is rendered when minimized or hidden
+   THROTTLE,
+   // as THROTTLE, and additionally render only after window events or IdlePolicyRequestRedraw
+   REDRAW_ON_DEMAND,
+};
+
+enum class IdleMode : u32 {
+   ACTIVE,
+   BACKGROUND,
+   HIDDEN,
+   WAITING_FOR_EVENTS,
+};
+
+constexpr const char* IdleModeToStr(IdleMode mode) {
+   switch (mode) {
+      case IdleMode::ACTIVE: return "ACTIVE";
+      case IdleMode::BACKGROUND: return "BACKGROUND";
+      case IdleMode::HIDDEN: return "HIDDEN";
+      case IdleMode::WAITING_FOR_EVENTS: return "WAITING_FOR_EVENTS";
+   }
+   return "UNKNOWN";
+}
+
+constexpr auto IdleModeIsRendering(IdleMode mode) -> b8 {
+   return mode == IdleMode::ACTIVE || mode == IdleMode::BACKGROUND;
+}
+
+struct IdlePolicy {
+   IdleBehavior Behavior;
+   f64 ActiveRateHz;
+   f64 BackgroundRateHz;
+   // how long to block on window events while nothing is rendered
+   f64 IdleWaitSec;
+   u64 LastEventCount;
+   b8 IsRedrawRequested;
+};
+
+auto CreateIdlePolicy(IdleBehavior, f64 activeRateHz, f64 backgroundRateHz = 30.0) -> IdlePolicy;
+// main thread only (queries window attributes), a rendering mode consumes the pending events and redraw request
+auto IdlePolicyUpdate(IdlePolicy&, const WindowHandle&) -> IdleMode;
+auto IdlePolicyRequestRedraw(IdlePolicy&) -> void;
+// frame rate cap for the mode (0 - uncapped)
+auto IdlePolicyTargetRate(const IdlePolicy&, IdleMode) -> f64;
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Prelude.hpp"
+
+#include <atomic>
+
+namespace dei::platform::input {
+
+enum class InputEventType : u8 {
+   KEY,
+   TEXT,
+   MOUSE_POSITION,
+   MOUSE_SCROLL,
+   MOUSE_BUTTON,
+   MOUSE_ENTERS,
+   WINDOW_POSITION,
+   WINDOW_RESIZE,
+   WINDOW_CLOSING,
+   WINDOW_FOCUS,
+   // only in input recordings, never dispatched
+   FRAME_BEGIN,
+};
+
+// events caused by the user on purpose, as opposed to the window system's notifications
+constexpr auto InputEventIsUserInput(InputEventType type) -> b8 {
+   switch (type) {
+      case InputEventType::KEY:
+      case InputEventType::TEXT:
+      case InputEventType::MOUSE_POSITION:
+      case InputEventType::MOUSE_SCROLL:
+      case InputEventType::MOUSE_BUTTON:
+         return true;
+      default:
+         return false;
+   }
+}
+
+// one record for any event type, the meaning of the fields depends on Type:
+// KEY: Code=KeyCode Action=KeyState Modifiers=GLFW_MOD_* X=scancode
+// TEXT: Code=codepoint
+// MOUSE_BUTTON: Code=MouseButton Action=MouseButtonState Modifiers=GLFW_MOD_*
+// MOUSE_POSITION, MOUSE_SCROLL, WINDOW_POSITION, WINDOW_RESIZE: X, Y
+// MOUSE_ENTERS, WINDOW_FOCUS: Code=0 or 1
+// FRAME_BEGIN: TimestampNanosec is the clock the frame's simulation advanced to
+struct InputEvent {
+   i64 TimestampNanosec; // GetMonotonicNanosec in the OS callback
+   InputEventType Type;
+   u8 Action;
+   u16 Modifiers;
+   i32 Code;
+   f64 X;
+   f64 Y;
+};
+static_assert(sizeof(InputEvent) == 32);
+
+constexpr u32 INPUT_EVENT_QUEUE_CAPACITY = 1024; // power of 2
+constexpr u32 INPUT_EVENT_QUEUE_MASK = INPUT_EVENT_QUEUE_CAPACITY - 1;
+
+// Preallocated ring, single producer (window callbacks on the main thread),
+// single consumer (whoever drains it once per frame, possibly on another thread)
+struct InputEventQueue {
+   alignas(64) std::atomic<u32> Head{0};
+   alignas(64) std::atomic<u32> Tail{0};
+   std::atomic<u32> NumDropped{0};
+   InputEvent Events[INPUT_EVENT_QUEUE_CAPACITY];
+};
+
+// drops the event if the consumer is a whole ring behind
+inline auto InputEventQueuePush(InputEventQueue& queue, const InputEvent& event) -> b8 {
+   auto head = queue.Head.load(std::memory_order_relaxed);
+   if (head - queue.Tail.load(std::memory_order_acquire) >= INPUT_EVENT_QUEUE_CAPACITY) {
+      queue.NumDropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+   }
+   queue.Events[head & INPUT_EVENT_QUEUE_MASK] = event;
+   queue.Head.store(head + 1, std::memory_order_release);
+   return true;
+}
+
+// calls onEvent(const InputEvent&) for every queued event in arrival order, returns how many
+template <typename OnEvent>
+inline auto InputEventQueueDrain(InputEventQueue& queue, OnEvent&& onEvent) -> u32 {
+   auto tail = queue.Tail.load(std::memory_order_relaxed);
+   auto head = queue.Head.load(std::memory_order_acquire);
+   for (auto index = tail; index != head; ++index) {
+      onEvent(static_cast<const InputEvent&>(queue.Events[index & INPUT_EVENT_QUEUE_MASK]));
+   }
+   queue.Tail.store(head, std::memory_order_release);
+   return head - tail;
+}
+
+}
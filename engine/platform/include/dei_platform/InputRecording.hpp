@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Prelude.hpp"
+#include "InputEvents.hpp"
+
+#include <cstdio>
+
+namespace dei::platform::input {
+
+// file layout: InputRecordingHeader, then InputRecord until the end of the file,
+// every frame ends with a FRAME_BEGIN record carrying the clock its simulation advanced to
+constexpr u32 INPUT_RECORDING_MAGIC = 0x52494544; // "DEIR"
+constexpr u32 INPUT_RECORDING_VERSION = 2;
+
+struct InputRecordingHeader {
+   u32 Magic;
+   u32 Version;
+   u32 RecordSize;
+   u32 Reserved;
+};
+
+struct InputRecord {
+   u64 FrameIndex; // number of WindowBeginInputFrame calls before the event was received
+   InputEvent Event;
+};
+static_assert(sizeof(InputRecord) == 40);
+
+// Either writes window events to a file or reads them back, frame by frame
+struct InputRecording {
+   std::FILE* File;
+   b8 IsReplaying;
+   b8 HasNextRecord;
+   InputRecord NextRecord;
+   u64 NumRecords;
+   // while replaying, from the latest FRAME_BEGIN record, 0 before the first one
+   i64 FrameNanosec;
+};
+
+auto InputRecordingOpenWrite(InputRecording&, const char* filepath) -> b8;
+auto InputRecordingOpenRead(InputRecording&, const char* filepath) -> b8;
+auto InputRecordingClose(InputRecording&) -> void;
+auto InputRecordingIsOpen(const InputRecording&) -> b8;
+// a failed write closes the recording, what was written before stays readable
+auto InputRecordingWrite(InputRecording&, u64 frameIndex, const InputEvent&) -> void;
+auto InputRecordingWriteFrame(InputRecording&, u64 frameIndex, i64 frameNanosec) -> void;
+// reads ahead one record, returns false at the end of the file
+auto InputRecordingReadNext(InputRecording&) -> b8;
+
+// calls dispatch(const InputEvent&) for every event of the frame and updates FrameNanosec,
+// returns false once the whole file is replayed
+template<typename DispatchFn>
+auto InputRecordingReplayFrame(InputRecording& recording, u64 frameIndex, DispatchFn&& dispatch) -> b8 {
+   while (recording.HasNextRecord && recording.NextRecord.FrameIndex <= frameIndex) {
+      auto record = recording.NextRecord;
+      InputRecordingReadNext(recording);
+      if (record.Event.Type == InputEventType::FRAME_BEGIN) {
+         recording.FrameNanosec = record.Event.TimestampNanosec;
+      } else {
+         dispatch(record.Event);
+      }
+   }
+   return recording.HasNextRecord;
+}
+
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include "Prelude.hpp"
+#include "Keyboard.hpp"
+#include "Mouse.hpp"
+#include "TypesVec.hpp"
+
+#include <atomic>
+#include <initializer_list>
+
+namespace dei::platform::input {
+
+// key codes go first, mouse buttons occupy the last word
+constexpr u32 INPUT_KEY_WORDS = (KEY_CODE_COUNT + 63) / 64;
+constexpr u32 INPUT_MOUSE_WORD = INPUT_KEY_WORDS;
+constexpr u32 INPUT_WORDS = INPUT_KEY_WORDS + 1;
+
+struct InputBitset {
+   u64 Words[INPUT_WORDS];
+};
+
+constexpr auto InputBitIndex(KeyCode key) -> u32 {
+   return static_cast<u32>(key);
+}
+
+constexpr auto InputBitIndex(MouseButton button) -> u32 {
+   return INPUT_MOUSE_WORD * 64 + static_cast<u32>(button);
+}
+
+constexpr auto InputBitsetTest(const InputBitset& bitset, u32 bitIndex) -> b8 {
+   return (bitset.Words[bitIndex / 64] >> (bitIndex % 64)) & 1u;
+}
+
+// set of keys and buttons for chord checks, e.g. constexpr InputBitset COPY = MakeInputChord({KeyCode::CTRL_LEFT, KeyCode::KEY_C}, {})
+constexpr auto MakeInputChord(std::initializer_list<KeyCode> keys, std::initializer_list<MouseButton> buttons) -> InputBitset {
+   auto chord = InputBitset{};
+   for (auto key : keys) {
+      auto bit = InputBitIndex(key);
+      chord.Words[bit / 64] |= u64{1} << (bit % 64);
+   }
+   for (auto button : buttons) {
+      auto bit = InputBitIndex(button);
+      chord.Words[bit / 64] |= u64{1} << (bit % 64);
+   }
+   return chord;
+}
+
+// Input as of the latest WindowLatchInputState: what is held, and what changed since the previous latch
+struct InputSnapshot {
+   InputBitset Down;
+   InputBitset Pressed;
+   InputBitset Released;
+};
+
+// Written by the window callbacks as events arrive, latched into InputSnapshot once per frame
+struct InputStateAccumulator {
+   std::atomic<u64> Down[INPUT_WORDS];
+   std::atomic<u64> Pressed[INPUT_WORDS];
+   std::atomic<u64> Released[INPUT_WORDS];
+};
+
+inline auto InputStateSetBit(InputStateAccumulator& state, u32 bitIndex, b8 isDown) -> void {
+   auto word = bitIndex / 64;
+   auto mask = u64{1} << (bitIndex % 64);
+   if (isDown) {
+      state.Down[word].fetch_or(mask, std::memory_order_relaxed);
+      state.Pressed[word].fetch_or(mask, std::memory_order_relaxed);
+   } else {
+      state.Down[word].fetch_and(~mask, std::memory_order_relaxed);
+      state.Released[word].fetch_or(mask, std::memory_order_relaxed);
+   }
+}
+
+// may run on another thread than the callbacks, an edge is reported by exactly one latch
+inline auto InputStateLatch(InputStateAccumulator& state, InputSnapshot& destination) -> void {
+   for (u32 word = 0; word < INPUT_WORDS; ++word) {
+      destination.Pressed.Words[word] = state.Pressed[word].exchange(0, std::memory_order_relaxed);
+      destination.Released.Words[word] = state.Released[word].exchange(0, std::memory_order_relaxed);
+      destination.Down.Words[word] = state.Down[word].load(std::memory_order_relaxed);
+   }
+}
+
+// fixed point, atomic fetch_add on doubles isn't portable
+constexpr f64 MOUSE_MOTION_UNITS_PER_PIXEL = 65536.0;
+
+// Sum of mouse movement and scrolling since it was last taken, accumulated by the window
+// callbacks (one atomic add per event), taken by the consumer at any time, e.g. right before
+// building the view matrix
+struct MouseMotionAccumulator {
+   std::atomic<i64> DeltaX;
+   std::atomic<i64> DeltaY;
+   std::atomic<i64> ScrollX;
+   std::atomic<i64> ScrollY;
+   // callback thread only
+   f64 LastX;
+   f64 LastY;
+   b8 HasLastPosition;
+};
+
+struct MouseMotion {
+   vec2ff Delta;
+   vec2ff Scroll;
+};
+
+inline auto MouseMotionAddPosition(MouseMotionAccumulator& accumulator, f64 x, f64 y) -> void {
+   if (accumulator.HasLastPosition) {
+      accumulator.DeltaX.fetch_add(static_cast<i64>((x - accumulator.LastX) * MOUSE_MOTION_UNITS_PER_PIXEL), std::memory_order_relaxed);
+      accumulator.DeltaY.fetch_add(static_cast<i64>((y - accumulator.LastY) * MOUSE_MOTION_UNITS_PER_PIXEL), std::memory_order_relaxed);
+   }
+   accumulator.LastX = x;
+   accumulator.LastY = y;
+   accumulator.HasLastPosition = true;
+}
+
+inline auto MouseMotionAddScroll(MouseMotionAccumulator& accumulator, f64 x, f64 y) -> void {
+   accumulator.ScrollX.fetch_add(static_cast<i64>(x * MOUSE_MOTION_UNITS_PER_PIXEL), std::memory_order_relaxed);
+   accumulator.ScrollY.fetch_add(static_cast<i64>(y * MOUSE_MOTION_UNITS_PER_PIXEL), std::memory_order_relaxed);
+}
+
+inline auto MouseMotionTake(MouseMotionAccumulator& accumulator) -> MouseMotion {
+   auto toPixels = [](i64 units) { return static_cast<f64>(units) / MOUSE_MOTION_UNITS_PER_PIXEL; };
+   auto motion = MouseMotion{};
+   motion.Delta.x = toPixels(accumulator.DeltaX.exchange(0, std::memory_order_relaxed));
+   motion.Delta.y = toPixels(accumulator.DeltaY.exchange(0, std::memory_order_relaxed));
+   motion.Scroll.x = toPixels(accumulator.ScrollX.exchange(0, std::memory_order_relaxed));
+   motion.Scroll.y = toPixels(accumulator.ScrollY.exchange(0, std::memory_order_relaxed));
+   return motion;
+}
+
+inline auto InputIsDown(const InputSnapshot& input, KeyCode key) -> b8 {
+   return InputBitsetTest(input.Down, InputBitIndex(key));
+}
+
+inline auto InputIsDown(const InputSnapshot& input, MouseButton button) -> b8 {
+   return InputBitsetTest(input.Down, InputBitIndex(button));
+}
+
+// went down since the previous frame (even if already released)
+inline auto InputWasPressed(const InputSnapshot& input, KeyCode key) -> b8 {
+   return InputBitsetTest(input.Pressed, InputBitIndex(key));
+}
+
+inline auto InputWasPressed(const InputSnapshot& input, MouseButton button) -> b8 {
+   return InputBitsetTest(input.Pressed, InputBitIndex(button));
+}
+
+inline auto InputWasReleased(const InputSnapshot& input, KeyCode key) -> b8 {
+   return InputBitsetTest(input.Released, InputBitIndex(key));
+}
+
+inline auto InputWasReleased(const InputSnapshot& input, MouseButton button) -> b8 {
+   return InputBitsetTest(input.Released, InputBitIndex(button));
+}
+
+// every key of the chord is held
+inline auto InputIsChordDown(const InputSnapshot& input, const InputBitset& chord) -> b8 {
+   u64 missing = 0;
+   for (u32 word = 0; word < INPUT_WORDS; ++word) {
+      missing |= chord.Words[word] & ~input.Down.Words[word];
+   }
+   return missing == 0;
+}
+
+// every key of the chord is held and at least one of them went down this frame
+inline auto InputWasChordPressed(const InputSnapshot& input, const InputBitset& chord) -> b8 {
+   u64 pressed = 0;
+   for (u32 word = 0; word < INPUT_WORDS; ++word) {
+      pressed |= chord.Words[word] & input.Pressed.Words[word];
+   }
+   return pressed != 0 && InputIsChordDown(input, chord);
+}
+
+}
@@ -2,9 +2,9 @@
 
 #include "Prelude.hpp"
 
-#include <unordered_map>
-#include <functional>
-#include <bitset>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
 
 namespace {
 
@@ -76,20 +76,131 @@ enum class KeyCode {
 };
 
 
-using ModifierKeysState = std::bitset<8>;
+// GLFW_MOD_* bits, lock keys are not part of key bindings
+struct ModifierKeysState {
+   u8 Bits;
+   constexpr auto operator|(ModifierKeysState other) const -> ModifierKeysState {
+      return ModifierKeysState{static_cast<u8>(Bits | other.Bits)};
+   }
+   constexpr auto operator|=(ModifierKeysState other) -> ModifierKeysState& {
+      Bits = static_cast<u8>(Bits | other.Bits);
+      return *this;
+   }
+   constexpr auto operator==(ModifierKeysState other) const -> bool { return Bits == other.Bits; }
+   constexpr auto operator!=(ModifierKeysState other) const -> bool { return Bits != other.Bits; }
+};
 constexpr ModifierKeysState MODIFIERS_NONE = {0};
 constexpr ModifierKeysState MODIFIERS_CTRL = {::MODIFIER_CTRL_BIT};
 constexpr ModifierKeysState MODIFIERS_SHIFT = {::MODIFIER_SHIFT_BIT};
 constexpr ModifierKeysState MODIFIERS_ALT = {::MODIFIER_ALT_BIT};
 constexpr ModifierKeysState MODIFIERS_SUPER = {::MODIFIER_SUPER_BIT};
 constexpr ModifierKeysState MODIFIERS_CTRL_SHIFT = {::MODIFIER_CTRL_BIT | ::MODIFIER_SHIFT_BIT};
+// ctrl, shift, alt, super
+constexpr u32 MODIFIER_COMBINATIONS = 16;
+
+constexpr auto ModifiersIndex(u32 glfwMods) -> u32 {
+   return glfwMods & (MODIFIER_COMBINATIONS - 1);
+}
+
+using KeyCallback = void (*)(KeyCode, KeyState, const char* keyName);
+
+// Callable with inline storage: a function pointer or a small trivially copyable
+// functor (e.g. a lambda capturing a few references), never allocates.
+// constexpr when made from a function pointer
+struct KeyAction {
+   static constexpr u32 STORAGE_SIZE = 32;
+
+   constexpr KeyAction() = default;
+   constexpr KeyAction(KeyCallback function) : _invoke(function == nullptr ? nullptr : &InvokeFunction), _function(function) {}
+   template <typename Functor, typename = std::enable_if_t<
+      !std::is_convertible_v<Functor, KeyCallback> && std::is_invocable_v<const Functor&, KeyCode, KeyState, const char*>>>
+   KeyAction(Functor functor) : _invoke(&InvokeFunctor<Functor>) {
+      static_assert(sizeof(Functor) <= STORAGE_SIZE, "KeyAction: the functor captures too much");
+      static_assert(alignof(Functor) <= alignof(u64), "KeyAction: the functor is overaligned");
+      static_assert(std::is_trivially_copyable_v<Functor> && std::is_trivially_destructible_v<Functor>,
+         "KeyAction: the functor must be trivially copyable");
+      new (_storage) Functor(functor);
+   }
+
+   auto operator()(KeyCode key, KeyState state, const char* keyName) const -> void {
+      _invoke(*this, key, state, keyName);
+   }
+   constexpr explicit operator bool() const { return _invoke != nullptr; }
+
+private:
+   using Invoke = void (*)(const KeyAction&, KeyCode, KeyState, const char*);
+
+   static auto InvokeFunction(const KeyAction& action, KeyCode key, KeyState state, const char* keyName) -> void {
+      action._function(key, state, keyName);
+   }
+   template <typename Functor>
+   static auto InvokeFunctor(const KeyAction& action, KeyCode key, KeyState state, const char* keyName) -> void {
+      (*std::launder(reinterpret_cast<const Functor*>(action._storage)))(key, state, keyName);
+   }
+
+   Invoke _invoke = nullptr;
+   KeyCallback _function = nullptr;
+   alignas(u64) unsigned char _storage[STORAGE_SIZE] = {};
+};
+
+struct KeyChord {
+   KeyCode Key;
+   ModifierKeysState Modifiers;
+};
+
+struct KeyBinding {
+   KeyChord Chord;
+   KeyAction Action;
+};
 
-using KeyMap = std::unordered_map<
-   std::pair<KeyCode, ModifierKeysState>,
-   std::function<void(KeyCode, KeyState, const char*)>,
-   pair_hash
->;
+// number of key codes indexing the table, KeyCode::ANYTHING (0) is the fallback binding
+constexpr u32 KEY_CODE_COUNT = GLFW_KEY_LAST + 1;
+constexpr u32 KEY_MAP_MAX_ACTIONS = 64;
 
-typedef void (*InputTextCallback)(const std::string& currentTextUtf8, u32 latestCodepoint);
+// Dense dispatch table: lookup is one load of the action slot by [key][modifiers],
+// copying or replacing a whole key map never allocates
+struct KeyMap {
+   constexpr KeyMap() = default;
+   constexpr KeyMap(std::initializer_list<KeyBinding> bindings) {
+      for (const auto& binding : bindings) {
+         Bind(binding.Chord, binding.Action);
+      }
+   }
+
+   // returns false if the key code is out of range or there are too many distinct actions
+   constexpr auto Bind(KeyChord chord, KeyAction action) -> b8 {
+      auto key = static_cast<i32>(chord.Key);
+      if (key < 0 || key >= static_cast<i32>(KEY_CODE_COUNT)) {
+         return false;
+      }
+      auto& slot = _slots[key][ModifiersIndex(chord.Modifiers.Bits)];
+      if (slot == 0) {
+         if (_numActions == KEY_MAP_MAX_ACTIONS) {
+            return false;
+         }
+         slot = static_cast<u8>(++_numActions);
+      }
+      _actions[slot - 1] = action;
+      return true;
+   }
+
+   // the exact binding, or the KeyCode::ANYTHING one, or null
+   constexpr auto Find(i32 key, u32 glfwMods) const -> const KeyAction* {
+      u8 slot = 0;
+      if (key >= 0 && key < static_cast<i32>(KEY_CODE_COUNT)) {
+         slot = _slots[key][ModifiersIndex(glfwMods)];
+      }
+      if (slot == 0) {
+         slot = _slots[static_cast<u32>(KeyCode::ANYTHING)][0];
+      }
+      return slot == 0 ? nullptr : &_actions[slot - 1];
+   }
+
+private:
+   // 0 - not bound, otherwise index + 1 in _actions
+   u8 _slots[KEY_CODE_COUNT][MODIFIER_COMBINATIONS] = {};
+   KeyAction _actions[KEY_MAP_MAX_ACTIONS] = {};
+   u32 _numActions = 0;
+};
 
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Prelude.hpp"
+#include "FrameStats.hpp"
+
+namespace dei::platform {
+
+// frames tracked between their begin and presentation, must exceed the frames in flight
+constexpr u32 LATENCY_PROBE_FRAMES = 8;
+
+struct LatencyProbeFrame {
+   u64 FrameId;
+   i64 InputNanosec; // 0 if the frame reflects no new input
+};
+
+// Input-to-photon latency: a frame takes the arrival time of the earliest input it's the first to see
+// (WindowTakeInputTimestamp right at the latch), the time is measured when that frame is presented.
+// Frames are reported by id with the time they were presented, which may reach the probe a few frames later
+// (a thread waiting for the present or the fence takes the time, the frame thread reports it).
+// Used on one thread, fixed-size storage
+struct LatencyProbe {
+   LatencyProbeFrame Frames[LATENCY_PROBE_FRAMES];
+   u64 NumFrames;
+   u64 NumSamples;
+   f32 LastSampleMs;
+   // receives the samples, may be null
+   FrameStats* Stats;
+   // set by a renderer that reports its frames (Vulkan present wait, or fences where it's missing),
+   // otherwise the host reports at the buffer swap
+   b8 IsReportedByRenderer;
+};
+
+// the frame begun last, which the renderer is working on
+inline auto LatencyProbeCurrentFrame(const LatencyProbe& probe) -> u64 {
+   return probe.NumFrames - 1;
+}
+
+// returns the id to report the frame's presentation with
+inline auto LatencyProbeBeginFrame(LatencyProbe& probe, i64 inputNanosec) -> u64 {
+   auto frameId = probe.NumFrames++;
+   probe.Frames[frameId % LATENCY_PROBE_FRAMES] = LatencyProbeFrame{ frameId, inputNanosec };
+   return frameId;
+}
+
+// records a INPUT_TO_PHOTON sample and returns it, 0 if the frame has no input or was reported already
+inline auto LatencyProbePresentFrame(LatencyProbe& probe, u64 frameId, i64 presentNanosec) -> f32 {
+   auto& frame = probe.Frames[frameId % LATENCY_PROBE_FRAMES];
+   if (frame.FrameId != frameId || frame.InputNanosec == 0) {
+      return 0.0f;
+   }
+   auto latencyMs = static_cast<f32>(presentNanosec - frame.InputNanosec) * 1e-6f;
+   frame.InputNanosec = 0;
+   ++probe.NumSamples;
+   probe.LastSampleMs = latencyMs;
+   if (probe.Stats != nullptr) {
+      FrameStatsRecord(*probe.Stats, FramePhase::INPUT_TO_PHOTON, latencyMs);
+   }
+   return latencyMs;
+}
+
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "Prelude.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+
+// calls below this level compile to nothing (make LOG_LEVEL=0 enables TRACE),
+// the levels are the values of dei::platform::LogLevel
+#if !defined(DEI_LOG_LEVEL)
+#define DEI_LOG_LEVEL 1
+#endif
+
+namespace dei::platform {
+
+enum class LogLevel : u8 {
+   TRACE,
+   DEBUG,
+   INFO,
+   WARN,
+   ERROR,
+};
+
+// formats a record's payload back into printf arguments
+using LogFormatFn = void (*)(std::FILE*, const char* format, const u8* payload);
+
+// Records are written in binary form (the format string pointer and the copied arguments)
+// into a lock-free ring of the calling thread; a writer thread formats them in timestamp order.
+// The format strings and LogFormatFn live in the caller's library: call LogFlush
+// before the engine library gets unloaded.
+// Before LogStart and after LogStop the records are formatted right away on the calling thread.
+auto LogStart() -> void;
+auto LogStop() -> void;
+// formats everything recorded so far, returns once it's written
+auto LogFlush() -> void;
+// allocates the calling thread's ring up front, otherwise done by its first record
+auto LogRegisterThread() -> void;
+// returns where to write numPayloadBytes of arguments, nullptr if the ring is full (the record is dropped)
+auto LogBeginRecord(LogLevel, const char* format, LogFormatFn, u32 numPayloadBytes) -> u8*;
+auto LogCommitRecord() -> void;
+
+constexpr auto IsLogLevelEnabled(int level) -> b8 {
+   return level >= DEI_LOG_LEVEL;
+}
+
+namespace internal {
+
+template<typename T>
+constexpr b8 IS_LOG_STRING = std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*>;
+
+// stored as printf would receive them after the default argument promotions
+template<typename T, typename = void>
+struct LogStored {
+   using Type = std::decay_t<T>;
+};
+template<typename T>
+struct LogStored<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+   using Type = f64;
+};
+template<typename T>
+struct LogStored<T, std::enable_if_t<std::is_enum_v<T>>> {
+   using Type = std::underlying_type_t<T>;
+};
+template<>
+struct LogStored<bool> {
+   using Type = int;
+};
+
+template<typename T>
+using LogDecoded = std::conditional_t<IS_LOG_STRING<T>, const char*, typename LogStored<T>::Type>;
+
+inline auto LogStringOrNull(const char* text) -> const char* {
+   return text != nullptr ? text : "(null)";
+}
+
+// strings are measured once, their lengths are kept here between LogArgSize and LogArgWrite
+template<typename T>
+inline auto LogArgSize(const T& arg, u32*& stringBytes) -> u32 {
+   if constexpr (IS_LOG_STRING<T>) {
+      auto numBytes = static_cast<u32>(std::strlen(LogStringOrNull(arg)) + 1);
+      *stringBytes++ = numBytes;
+      return static_cast<u32>(sizeof(u32)) + numBytes;
+   } else {
+      (void)stringBytes;
+      return sizeof(typename LogStored<T>::Type);
+   }
+}
+
+template<typename T>
+inline auto LogArgWrite(u8*& cursor, const T& arg, const u32*& stringBytes) -> void {
+   if constexpr (IS_LOG_STRING<T>) {
+      auto numBytes = *stringBytes++;
+      std::memcpy(cursor, &numBytes, sizeof(numBytes));
+      std::memcpy(cursor + sizeof(numBytes), LogStringOrNull(arg), numBytes);
+      cursor += sizeof(numBytes) + numBytes;
+   } else {
+      (void)stringBytes;
+      auto stored = static_cast<typename LogStored<T>::Type>(arg);
+      std::memcpy(cursor, &stored, sizeof(stored));
+      cursor += sizeof(stored);
+   }
+}
+
+template<typename T>
+inline auto LogArgRead(const u8*& cursor) -> LogDecoded<T> {
+   if constexpr (IS_LOG_STRING<T>) {
+      u32 numBytes;
+      std::memcpy(&numBytes, cursor, sizeof(numBytes));
+      const auto* text = reinterpret_cast<const char*>(cursor + sizeof(numBytes));
+      cursor += sizeof(numBytes) + numBytes;
+      return text;
+   } else {
+      typename LogStored<T>::Type stored;
+      std::memcpy(&stored, cursor, sizeof(stored));
+      cursor += sizeof(stored);
+      return stored;
+   }
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wformat-nonliteral"
+#pragma clang diagnostic ignored "-Wformat-security"
+template<typename... Args>
+auto LogFormatRecord(std::FILE* file, const char* format, const u8* payload) -> void {
+   // braced initialization reads the arguments left to right
+   auto arguments = std::tuple<LogDecoded<Args>...>{ LogArgRead<Args>(payload)... };
+   (void)payload;
+   std::apply([&](const auto&... values) { std::fprintf(file, format, values...); }, arguments);
+}
+#pragma clang diagnostic pop
+
+} // namespace internal
+
+// the caller only copies the arguments, see DEI_LOG_INFO and others
+template<typename... Args>
+auto LogWrite(LogLevel level, const char* format, const Args&... args) -> void {
+   constexpr auto numStrings = (size_t{0} + ... + size_t{internal::IS_LOG_STRING<Args>});
+   u32 stringBytes[numStrings + 1];
+   auto* stringBytesEnd = stringBytes;
+   // comma folds run left to right, the lengths are read back in the same order below
+   u32 numPayloadBytes = 0;
+   ((numPayloadBytes += internal::LogArgSize(args, stringBytesEnd)), ...);
+   (void)stringBytesEnd;
+   auto* cursor = LogBeginRecord(level, format, &internal::LogFormatRecord<Args...>, numPayloadBytes);
+   if (cursor == nullptr) {
+      return;
+   }
+   const auto* stringBytesBegin = static_cast<const u32*>(stringBytes);
+   (internal::LogArgWrite(cursor, args, stringBytesBegin), ...);
+   (void)stringBytesBegin;
+   LogCommitRecord();
+}
+
+}
+
+// the format must be a string literal, it's checked like printf's
+#define DEI_LOG_AT(level, ...) \
+   do { \
+      if constexpr (::dei::platform::IsLogLevelEnabled(static_cast<int>(::dei::platform::LogLevel::level))) { \
+         (void)sizeof(std::printf(__VA_ARGS__)); \
+         ::dei::platform::LogWrite(::dei::platform::LogLevel::level, __VA_ARGS__); \
+      } \
+   } while (false)
+
+#define DEI_LOG_TRACE(...) DEI_LOG_AT(TRACE, __VA_ARGS__)
+#define DEI_LOG_DEBUG(...) DEI_LOG_AT(DEBUG, __VA_ARGS__)
+#define DEI_LOG_INFO(...) DEI_LOG_AT(INFO, __VA_ARGS__)
+#define DEI_LOG_WARN(...) DEI_LOG_AT(WARN, __VA_ARGS__)
+#define DEI_LOG_ERROR(...) DEI_LOG_AT(ERROR, __VA_ARGS__)
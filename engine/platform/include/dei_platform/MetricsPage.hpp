@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Prelude.hpp"
+
+#include <atomic>
+#include <optional>
+#include <string>
+
+namespace dei::platform {
+
+constexpr u32 METRICS_PAGE_MAGIC = 0x4D494544; // "DEIM"
+constexpr u32 METRICS_PAGE_VERSION = 2;
+
+// the layout is the protocol for external readers, only append fields and bump the version
+struct MetricsSnapshot {
+   i64 PublishNanosec; // monotonic clock
+   u64 FrameIndex;
+   u32 DrawCounter;
+   u32 NumReloads;
+   u32 NumReloadFailures;
+   u32 Reserved;
+   f32 FrameLastMs;
+   f32 FrameP50Ms;
+   f32 FrameP99Ms;
+   f32 FrameMaxMs;
+   f32 TickLastMs;
+   f32 TickP50Ms;
+   f32 TickP99Ms;
+   f32 TickMaxMs;
+   u64 ResidentBytes;
+   u64 NumAllocations;
+   // version 2: host memory of the Vulkan driver, see VulkanAllocator.hpp
+   u64 VulkanLiveBytes;
+   u64 VulkanInternalBytes;
+};
+
+// Shared memory page, written by one process with a sequence lock:
+// Sequence is odd while the snapshot is being written, readers retry until
+// they read the same even value before and after copying the snapshot
+struct MetricsPage {
+   u32 Magic;
+   u32 Version;
+   u32 ProcessId;
+   u32 SnapshotSize;
+   std::atomic<u64> Sequence;
+   MetricsSnapshot Snapshot;
+};
+
+struct MetricsPublisher {
+   MetricsPage* Page;
+   std::string Name;
+};
+
+// creates /dev/shm/<namePrefix>_<process id> on Linux, unsupported elsewhere
+auto CreateMetricsPublisher(const char* namePrefix) -> std::optional<MetricsPublisher>;
+auto DestroyMetricsPublisher(MetricsPublisher&) -> void;
+// never blocks, readers don't affect the writer
+auto MetricsPublish(MetricsPublisher&, const MetricsSnapshot&) -> void;
+// reader side, returns false if the writer kept interrupting the copy
+auto MetricsPageRead(const MetricsPage&, MetricsSnapshot& destination) -> b8;
+// current resident set size of this process (0 if unknown)
+auto GetResidentBytes() -> u64;
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Prelude.hpp"
+#include "Time.hpp"
+
+// compile with DEI_PROFILER_ENABLED=1 (make PROFILE=y) to record DEI_PROFILE_SCOPE,
+// otherwise the macro expands to nothing
+#if !defined(DEI_PROFILER_ENABLED)
+#define DEI_PROFILER_ENABLED 0
+#endif
+
+namespace dei::platform {
+
+enum class ProfilerEventType : u32 {
+   BEGIN,
+   END,
+};
+
+// Names are copied into storage owned by libdeiPlatform, recorded events refer to
+// them by id, so the trace stays valid after the engine library gets hot-reloaded
+auto ProfilerInternName(const char* name) -> u32;
+// Appends to the calling thread's buffer, drops the event if the buffer is full
+auto ProfilerEmit(u32 nameId, ProfilerEventType, u64 clockCounter) -> void;
+// Spawns a writer thread which flushes events into Chrome trace JSON
+// (opens in chrome://tracing and ui.perfetto.dev)
+auto ProfilerStart(const char* traceFilepath) -> b8;
+auto ProfilerStop() -> void;
+auto ProfilerIsRunning() -> b8;
+
+class ProfilerScope {
+public:
+   explicit ProfilerScope(u32 nameId) : _nameId(nameId) {
+      ProfilerEmit(_nameId, ProfilerEventType::BEGIN, GetClockCounterUnfused());
+   }
+   ~ProfilerScope() {
+      ProfilerEmit(_nameId, ProfilerEventType::END, GetClockCounterUnfused());
+   }
+   ProfilerScope(const ProfilerScope&) = delete;
+   auto operator=(const ProfilerScope&) -> ProfilerScope& = delete;
+private:
+   u32 _nameId;
+};
+
+}
+
+#define DEI_PROFILE_CONCAT_IMPL(a, b) a##b
+#define DEI_PROFILE_CONCAT(a, b) DEI_PROFILE_CONCAT_IMPL(a, b)
+
+#if DEI_PROFILER_ENABLED
+#define DEI_PROFILE_SCOPE(name) \
+   static const u32 DEI_PROFILE_CONCAT(deiProfileName_, __LINE__) = \
+      ::dei::platform::ProfilerInternName(name); \
+   ::dei::platform::ProfilerScope DEI_PROFILE_CONCAT(deiProfileScope_, __LINE__){ \
+      DEI_PROFILE_CONCAT(deiProfileName_, __LINE__)}
+#else
+#define DEI_PROFILE_SCOPE(name) do {} while (false)
+#endif
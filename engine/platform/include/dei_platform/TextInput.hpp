@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Prelude.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dei::platform::input {
+
+enum class TextEditType : u8 {
+   INSERT,
+   ERASE,
+};
+
+// The change made by one edit, so the listeners don't need to rescan the whole text
+struct TextEdit {
+   TextEditType Type;
+   u32 OffsetBytes;
+   // inserted or erased bytes (whole codepoints), valid until the next edit of the buffer
+   std::string_view TextUtf8;
+   u32 TotalBytes; // text length after the edit
+};
+
+typedef void (*InputTextCallback)(const TextEdit& edit);
+
+struct TextUndoRecord {
+   TextEditType Type;
+   u32 OffsetBytes;
+   u32 NumBytes;
+   u32 UndoBytesOffset; // erased text in TextBuffer::UndoBytes
+};
+
+// at most this many edits can be undone
+constexpr u32 TEXT_UNDO_MAX_RECORDS = 1024;
+
+// Gap buffer of UTF-8 text: the gap follows the cursor, so typing and erasing
+// near the cursor move only the edited bytes, not the rest of the text
+struct TextBuffer {
+   // [0, GapBegin) - text before the cursor, [GapEnd, size) - text after the cursor
+   std::vector<char> Storage;
+   u32 GapBegin;
+   u32 GapEnd;
+   std::vector<TextUndoRecord> UndoRecords;
+   std::string UndoBytes;
+};
+
+auto TextBufferSize(const TextBuffer&) -> u32;
+// in bytes, always at a codepoint boundary
+auto TextBufferCursor(const TextBuffer&) -> u32;
+// inserts at the cursor, the cursor moves past the inserted text
+auto TextBufferInsert(TextBuffer&, std::string_view textUtf8) -> TextEdit;
+// nullopt if the codepoint can't be encoded
+auto TextBufferInsertCodepoint(TextBuffer&, u32 codepoint) -> std::optional<TextEdit>;
+// erases whole codepoints before the cursor
+auto TextBufferErase(TextBuffer&, u32 numCodepoints) -> TextEdit;
+auto TextBufferClear(TextBuffer&) -> TextEdit;
+// by codepoints, negative - towards the beginning
+auto TextBufferMoveCursor(TextBuffer&, i32 numCodepoints) -> void;
+// reverts the latest insert, erase or clear, nullopt if there's nothing to undo
+auto TextBufferUndo(TextBuffer&) -> std::optional<TextEdit>;
+// the whole text is contiguous only when copied out
+auto TextBufferCopyUtf8(const TextBuffer&, std::string& destination) -> void;
+
+}
@@ -8,6 +8,7 @@
 #include <windows.h>
 #elif defined(DEI_LINUX)
 #include <unistd.h>
+#include <time.h>
 #endif
 
 namespace dei::platform {
@@ -85,12 +86,28 @@ inline auto ThreadSleepMs(u32 ms) -> void {
     Sleep( ms );
 }
 
+inline auto GetMonotonicNanosec() -> i64 {
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    auto seconds = counter.QuadPart / frequency.QuadPart;
+    auto remainder = counter.QuadPart % frequency.QuadPart;
+    return seconds * 1000000000LL + (remainder * 1000000000LL) / frequency.QuadPart;
+}
+
 #elif defined(DEI_LINUX)
 
-auto ThreadSleepMs(u32 ms) -> void {
+inline auto ThreadSleepMs(u32 ms) -> void {
     usleep( ms * 1000 );
 }
 
+// CLOCK_MONOTONIC, the same clock that FramePacer sleeps on
+inline auto GetMonotonicNanosec() -> i64 {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<i64>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
 #endif // DEI_LINUX
 
 }
\ No newline at end of file
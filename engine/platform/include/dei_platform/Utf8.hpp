@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Prelude.hpp"
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace dei::platform {
+
+enum class SimdLevel : u8 {
+   SCALAR,
+   SSE2,
+   AVX2,
+};
+
+// the best level the CPU supports, unless forced with Utf8ForceSimdLevel
+auto Utf8GetSimdLevel() -> SimdLevel;
+// for benchmarks and tests, levels above the supported one are clamped
+auto Utf8ForceSimdLevel(SimdLevel) -> void;
+
+// returns the number of bytes written (up to 4), 0 for surrogates and values past U+10FFFF
+inline auto Utf8EncodeCodepoint(u32 codepoint, char* destination) -> u32 {
+   if (codepoint < 0x80) {
+      destination[0] = static_cast<char>(codepoint);
+      return 1;
+   }
+   if (codepoint < 0x800) {
+      destination[0] = static_cast<char>(0xC0 | (codepoint >> 6));
+      destination[1] = static_cast<char>(0x80 | (codepoint & 0x3F));
+      return 2;
+   }
+   if (codepoint >= 0xD800 && codepoint <= 0xDFFF) {
+      return 0;
+   }
+   if (codepoint < 0x10000) {
+      destination[0] = static_cast<char>(0xE0 | (codepoint >> 12));
+      destination[1] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+      destination[2] = static_cast<char>(0x80 | (codepoint & 0x3F));
+      return 3;
+   }
+   if (codepoint <= 0x10FFFF) {
+      destination[0] = static_cast<char>(0xF0 | (codepoint >> 18));
+      destination[1] = static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+      destination[2] = static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+      destination[3] = static_cast<char>(0x80 | (codepoint & 0x3F));
+      return 4;
+   }
+   return 0;
+}
+
+// rejects overlong forms, surrogates, values past U+10FFFF and truncated sequences
+auto Utf8Validate(const char* sourceUtf8, size_t numBytes) -> b8;
+auto Utf8CountCodepoints(const char* sourceUtf8, size_t numBytes) -> size_t;
+// the destination must fit numBytes codepoints, returns the number written or nullopt on invalid input
+auto Utf8ToUtf32(const char* sourceUtf8, size_t numBytes, char32_t* destination) -> std::optional<size_t>;
+// the destination must fit 4 * numCodepoints bytes, returns the number written or nullopt on invalid input
+auto Utf32ToUtf8(const char32_t* source, size_t numCodepoints, char* destinationUtf8) -> std::optional<size_t>;
+
+inline auto Utf8Validate(std::string_view sourceUtf8) -> b8 {
+   return Utf8Validate(sourceUtf8.data(), sourceUtf8.size());
+}
+
+inline auto AppendUtf8(std::string& destination, u32 codepoint) -> b8 {
+   char encoded[4];
+   auto numBytes = Utf8EncodeCodepoint(codepoint, encoded);
+   destination.append(encoded, numBytes);
+   return numBytes > 0;
+}
+
+// appends to the destination, which is left unchanged on invalid input
+auto AppendUtf32AsUtf8(std::string& destination, std::u32string_view source) -> b8;
+auto AppendUtf8AsUtf32(std::u32string& destination, std::string_view sourceUtf8) -> b8;
+
+}
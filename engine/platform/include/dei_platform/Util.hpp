@@ -1,30 +1,18 @@
 #pragma once
 
 #include <dei_platform/TypesFwd.hpp>
+#include <dei_platform/Format.hpp>
 
 #include <string>
-#include <sstream>
 
 namespace dei::platform {
 
-template <typename T>
-auto PutIntoStringStream(std::stringstream& ss, T t) -> void
-{
-    ss << t;
-}
-
-template<typename T, typename... Args>
-auto PutIntoStringStream(std::stringstream& ss, T t, Args... args) -> void
-{
-    ss << t;
-    PutIntoStringStream(ss, args...) ;
-}
-
+// for paths and names built once, see FormatTo for text updated every frame
 template<typename... Args>
-auto StringJoin(Args... args) -> std::string {
-    std::stringstream ss;
-    PutIntoStringStream(ss, args...);
-    return ss.str();
+auto StringJoin(const Args&... args) -> std::string {
+    auto result = std::string{};
+    (FormatAppendValue(result, args), ...);
+    return result;
 }
 
 auto SetSubstringInplace(std::string& destination, const char* source, size_t offset, size_t size, char padValue) -> void;
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Prelude.hpp"
+
+namespace dei::platform {
+
+// VkSystemAllocationScope values
+constexpr u32 VULKAN_ALLOCATION_SCOPE_COUNT = 5;
+
+constexpr const char* VulkanAllocationScopeToStr(u32 scope) {
+   switch (scope) {
+      case VK_SYSTEM_ALLOCATION_SCOPE_COMMAND: return "COMMAND";
+      case VK_SYSTEM_ALLOCATION_SCOPE_OBJECT: return "OBJECT";
+      case VK_SYSTEM_ALLOCATION_SCOPE_CACHE: return "CACHE";
+      case VK_SYSTEM_ALLOCATION_SCOPE_DEVICE: return "DEVICE";
+      case VK_SYSTEM_ALLOCATION_SCOPE_INSTANCE: return "INSTANCE";
+   }
+   return "UNKNOWN";
+}
+
+struct VulkanAllocationScopeStats {
+   u64 NumAllocations;
+   u64 NumLive;
+   u64 LiveBytes;
+   u64 PeakBytes;
+};
+
+struct VulkanAllocationStats {
+   VulkanAllocationScopeStats Scopes[VULKAN_ALLOCATION_SCOPE_COUNT];
+   // of all the scopes
+   u64 LiveBytes;
+   // reported by the driver through the internal allocation notifications
+   u64 InternalBytes;
+   // COMMAND allocations which didn't fit the calling thread's arena
+   u64 NumArenaOverflows;
+   // the most a thread's arena held within one frame
+   u64 ArenaPeakBytes;
+};
+
+// Host memory of the Vulkan driver, pass them to every vkCreate*, vkAllocate* and their vkDestroy*, vkFree*.
+// COMMAND scope allocations come from a per-thread arena rewound every frame (and whenever it's empty),
+// the longer scopes from size-class pools, larger ones from the heap, all tagged AllocationTag::VULKAN.
+// The callbacks live in libdeiPlatform, so the driver may still call them after the engine is reloaded
+auto GetVulkanAllocationCallbacks() -> const VkAllocationCallbacks*;
+// rewinds the calling thread's arena, call before the frame's first Vulkan command
+auto VulkanAllocatorBeginFrame() -> void;
+auto VulkanAllocatorQueryStats() -> VulkanAllocationStats;
+auto PrintVulkanAllocationStats() -> void;
+
+}
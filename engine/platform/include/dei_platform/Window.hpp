@@ -5,7 +5,11 @@
 #include "Keyboard.hpp"
 #include "Mouse.hpp"
 #include "Monitor.hpp"
+#include "InputEvents.hpp"
+#include "InputState.hpp"
+#include "TextInput.hpp"
 
+#include <atomic>
 #include <memory>
 #include <optional>
 
@@ -13,9 +17,14 @@ namespace dei::platform {
 
 auto CreateWindowSystem(void (*errorCallback)(int, const char*) = nullptr) -> WindowSystemHandle;
 auto PollWindowEvents(const WindowSystemHandle&) -> void;
+// blocks the (main) thread until an event arrives or the timeout passes
+auto WaitWindowEvents(const WindowSystemHandle&, f64 timeoutSec) -> void;
+// unblocks WaitWindowEvents, can be called from any thread
+auto WakeWindowEvents(const WindowSystemHandle&) -> void;
 auto GetKeyName(const WindowSystemHandle&, input::KeyCode) -> const char*;
 auto GetClipboardUtf8(const WindowSystemHandle&) -> const char *;
 auto SetClipboardUtf8(const WindowSystemHandle&, const char* textUtff8) -> void;
+// swap interval of the OpenGL context current on the calling thread, Vulkan windows use WindowSetPresentPolicy
 auto SetVerticalSync(const WindowSystemHandle&, b8 enableVerticalSync) -> void;
 
 typedef void (*WindowResizeCallback)(int widthPx, int heightPx);
@@ -41,6 +50,38 @@ constexpr const char* ContextCreationApiToStr(ContextCreationApi api) {
    std::exit(1);
 };
 
+// how a renderer presents to the window, mapped to the present modes the surface supports
+enum class PresentPolicy : u8 {
+   VSYNC,           // FIFO
+   ADAPTIVE_VSYNC,  // FIFO_RELAXED, else FIFO: a late frame tears instead of waiting for the next refresh
+   LOW_LATENCY,     // MAILBOX, else IMMEDIATE, else FIFO: the newest frame is shown at the refresh, no tearing
+   UNCAPPED,        // IMMEDIATE, else MAILBOX, else FIFO: frames are shown right away, tearing
+};
+
+constexpr const char* PresentPolicyToStr(PresentPolicy policy) {
+   switch (policy) {
+      case PresentPolicy::VSYNC: return "VSYNC";
+      case PresentPolicy::ADAPTIVE_VSYNC: return "ADAPTIVE_VSYNC";
+      case PresentPolicy::LOW_LATENCY: return "LOW_LATENCY";
+      case PresentPolicy::UNCAPPED: return "UNCAPPED";
+   }
+   return "UNKNOWN";
+}
+
+// What a swapchain needs from the window, may be read from another thread.
+// The size is updated by every framebuffer resize, renderers debounce with LastResizeNanosec
+struct WindowSurfaceState {
+   std::atomic<u64> FramebufferSizePx; // width << 32 | height
+   std::atomic<i64> LastResizeNanosec;
+   std::atomic<u32> NumResizes;
+   std::atomic<PresentPolicy> Present;
+};
+
+inline auto WindowSurfaceGetSize(const WindowSurfaceState& surface) -> vec2i {
+   auto packed = surface.FramebufferSizePx.load(std::memory_order_relaxed);
+   return vec2i{ static_cast<i32>(packed >> 32), static_cast<i32>(packed & 0xFFFFFFFF) };
+}
+
 enum class FullscreenMode {
    FULLSCREEN,
    WINDOWED,
@@ -105,6 +146,7 @@ struct CreateWindowArgs {
    input::MouseButtonCallback MouseButtonCallback = nullptr;
    input::MouseScrollCallback MouseScrollCallback = nullptr;
    input::MouseEntersWindowCallback MouseEntersWindowCallback = nullptr;
+   b8 IsInputBuffered = false;
 };
 
 struct WindowBuilder {
@@ -153,6 +195,8 @@ struct WindowBuilder {
    auto WithMouseButtonCallback(input::MouseButtonCallback) -> WindowBuilder&;
    auto WithMouseScrollCallback(input::MouseScrollCallback) -> WindowBuilder&;
    auto WithMouseEntersWindowCallback(input::MouseEntersWindowCallback) -> WindowBuilder&;
+   // events are queued with timestamps (see WindowGetInputEventQueue) instead of calling the callbacks and the key map
+   auto WithBufferedInput(b8 isInputBuffered) -> WindowBuilder&;
    auto IsValid() const -> b8;
    friend auto CreateWindow(const WindowSystemHandle& windowSystem, WindowBuilder&& builder) -> std::optional<WindowHandle>;
 private:
@@ -163,13 +207,49 @@ auto CreateWindow(const WindowSystemHandle& windowSystem, WindowBuilder&& builde
 auto CreateWindow(const WindowSystemHandle& windowSystem, CreateWindowArgs&& builder) -> std::optional<WindowHandle>;
 auto WindowSetTitleUtf8(const WindowHandle&, const char* titleUtf8) -> void;
 auto WindowIsClosing(const WindowHandle&) -> b8;
+// once per frame: the snapshot gets the current key/button state and the edges since the previous latch
+auto WindowLatchInputState(const WindowHandle&) -> void;
+// arrival time (GetMonotonicNanosec) of the earliest key, text or mouse event since the previous call, 0 if none.
+// Called right at the latch, it's the input the coming frame is the first to reflect
+auto WindowTakeInputTimestamp(const WindowHandle&) -> i64;
+// once per frame after polling, before the latch: advances the frame index stored with recorded events,
+// when replaying dispatches the recorded events of this frame. Returns true while replaying
+auto WindowBeginInputFrame(const WindowHandle&) -> b8;
+// writes all window and input events to a binary file (see InputRecording.hpp) until stopped or the window is destroyed
+auto WindowStartInputRecording(const WindowHandle&, const char* filepath) -> b8;
+// dispatches a recording frame by frame through the window callbacks, live input is ignored meanwhile
+auto WindowStartInputReplay(const WindowHandle&, const char* filepath) -> b8;
+// DEI_INPUT_REPLAY=<file> replays, otherwise DEI_INPUT_RECORD=<file> records
+auto WindowStartInputRecordingFromEnvironment(const WindowHandle&) -> b8;
+auto WindowStopInputRecording(const WindowHandle&) -> void;
+// false after the last recorded frame
+auto WindowIsReplayingInput(const WindowHandle&) -> b8;
+// the clock of the latest WindowBeginInputFrame: GetMonotonicNanosec, the recorded one while replaying input
+// (shifted to start at the time the replay started), so replays advance the simulation the same way
+auto WindowGetFrameNanosec(const WindowHandle&) -> const i64&;
+// valid until the next latch
+auto WindowGetInputSnapshot(const WindowHandle&) -> const input::InputSnapshot&;
+// mouse movement and scrolling accumulated across events, see MouseMotionTake
+auto WindowGetMouseMotion(const WindowHandle&) -> input::MouseMotionAccumulator&;
+// null unless created WithBufferedInput
+auto WindowGetInputEventQueue(const WindowHandle&) -> input::InputEventQueue*;
+// total number of input and window events received so far
+auto WindowGetEventCount(const WindowHandle&) -> u64;
 auto WindowGetSize(const WindowHandle&) -> vec2i;
+// framebuffer size and present policy for the renderer
+auto WindowGetSurfaceState(const WindowHandle&) -> WindowSurfaceState&;
+// the Vulkan counterpart of SetVerticalSync, picked up by the swapchain on its next frame
+auto WindowSetPresentPolicy(const WindowHandle&, PresentPolicy) -> void;
 auto WindowSetSize(const WindowHandle&, vec2i size) -> void;
 auto WindowSetKeyMap(const WindowHandle&, input::KeyMap&&) -> void;
 auto WindowSwapBuffers(const WindowHandle&) -> void;
+// text input edits notify InputTextCallback with just the changed range
 auto WindowAppendInputUtf8(const WindowHandle&, const char* textUtf8) -> void;
+auto WindowEraseInput(const WindowHandle&, u32 numCodepoints = 1) -> void;
 auto WindowClearInput(const WindowHandle&) -> void;
+// reverts the latest append, erase or clear
 auto WindowUndoInput(const WindowHandle&) -> void;
+auto WindowGetInputText(const WindowHandle&) -> const input::TextBuffer&;
 auto WindowGetMousePosition(const WindowHandle&) -> vec2ff;
 auto WindowGetMousePosition(const WindowHandle&, vec2ff& destination) -> void;
 auto WindowSetCursorMode(const WindowHandle&, input::CursorMode mode) -> void;